@@ -0,0 +1,8 @@
+#!/bin/bash
+
+# Build target
+./bin/make.sh
+
+# Run microbenchmarks of the core routines, options (e.g. --row-sweep) are
+# passed through
+./loesung --benchmark "$@"
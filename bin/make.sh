@@ -1,4 +1,4 @@
 #!/bin/bash
 
 # Build target
-gcc -o loesung -O3 -std=c11 -Wall -Werror -DNDEBUG src/main.c
+gcc -o loesung -O3 -std=c11 -pthread -Wall -Werror -DNDEBUG src/main.c
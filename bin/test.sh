@@ -6,27 +6,125 @@
 # Temporary stdout write location
 TEST_STDOUT=./test.stdout
 
-# Iterate through tests
-for CASE_STDIN_PATH in ./tests/*.stdin
+# Modes expected to produce exactly the same board as the default mode
+TEST_MODES=(
+  ""
+  "--pipeline"
+  "--speculative"
+  "--bitboard-check"
+  "--row-sweep"
+  "--memory-budget=4K"
+)
+
+# Number of failed tests
+FAILED=0
+
+# Iterate through modes and tests
+for MODE in "${TEST_MODES[@]}"
+do
+  for CASE_STDIN_PATH in ./tests/*.stdin
+  do
+    CASE_NAME="$(basename ${CASE_STDIN_PATH%.*})${MODE:+ ($MODE)}"
+    CASE_STDOUT_PATH="${CASE_STDIN_PATH%.*}.stdout"
+
+    # Run test
+    cat $CASE_STDIN_PATH | ./loesung $MODE | sort > $TEST_STDOUT
+
+    # Diff result
+    CASE_DIFF=$(diff <(sort $CASE_STDOUT_PATH) $TEST_STDOUT)
+
+    # Check if diff empty
+    if [ "$CASE_DIFF" != "" ]
+    then
+      DIFF_DELTA="$(wc -l <<< "$CASE_DIFF")"
+      echo -e "\x1B[1;31m✕ Test $CASE_NAME\x1B[0m (Delta: $DIFF_DELTA)"
+      FAILED=$((FAILED + 1))
+    else
+      echo -e "\x1B[1;32m✓ Test $CASE_NAME\x1B[0m"
+    fi
+  done
+done
+
+# Batch mode: Play all batch cases at once and compare each resulting board
+# to the board of the case played on its own. Cases with unexpected input
+# must not produce a board. The stack is limited to catch recursion over
+# the moves of long games.
+for MODE in "" "--lockstep"
+do
+  (ulimit -s 1024; ./loesung $MODE --batch ./tests/batch/*.stdin 2> /dev/null)
+
+  for CASE_STDIN_PATH in ./tests/batch/*.stdin
+  do
+    CASE_NAME="batch/$(basename ${CASE_STDIN_PATH%.*}) (--batch${MODE:+ $MODE})"
+    CASE_OUT_PATH="$CASE_STDIN_PATH.out"
+
+    # Run case on its own
+    if ./loesung < $CASE_STDIN_PATH 2> /dev/null | sort > $TEST_STDOUT && [ ${PIPESTATUS[0]} -eq 0 ]
+    then
+      CASE_DIFF=$(diff $TEST_STDOUT <(sort $CASE_OUT_PATH 2> /dev/null))
+    else
+      CASE_DIFF=$(ls $CASE_OUT_PATH 2> /dev/null)
+    fi
+
+    # Check if diff empty
+    if [ "$CASE_DIFF" != "" ]
+    then
+      DIFF_DELTA="$(wc -l <<< "$CASE_DIFF")"
+      echo -e "\x1B[1;31m✕ Test $CASE_NAME\x1B[0m (Delta: $DIFF_DELTA)"
+      FAILED=$((FAILED + 1))
+    else
+      echo -e "\x1B[1;32m✓ Test $CASE_NAME\x1B[0m"
+    fi
+  done
+
+  rm -f ./tests/batch/*.out
+done
+
+# Export mode: Read the board published to shared memory once it holds all
+# moves, while the input is still open, and compare it to the printed board.
+# The reader checks the segment layout and follows the seqlock protocol.
+EXPORT_READER=./export-reader
+EXPORT_NAME=/crushing-four-test-$$
+EXPORT_HOLD=./test.hold
+gcc -o $EXPORT_READER -O2 -std=c11 -Wall -Werror ./tests/export/reader.c
+
+for MODE in "" "--pipeline"
 do
-  CASE_NAME="$(basename ${CASE_STDIN_PATH%.*})"
-  CASE_STDOUT_PATH="${CASE_STDIN_PATH%.*}.stdout"
-
-  # Run test
-  cat $CASE_STDIN_PATH | time ./loesung | sort > $TEST_STDOUT
-
-  # Diff result
-  CASE_DIFF=$(diff <(sort $CASE_STDOUT_PATH) $TEST_STDOUT)
-
-  # Check if diff empty
-  if [ "$CASE_DIFF" != "" ]
-  then
-    DIFF_DELTA="$(wc -l <<< "$CASE_DIFF")"
-    echo -e "\x1B[1;31m✕ Test $CASE_NAME\x1B[0m (Delta: $DIFF_DELTA)"
-  else
-    echo -e "\x1B[1;32m✓ Test $CASE_NAME\x1B[0m"
-  fi
+  for CASE_STDIN_PATH in ./tests/{002-test-expand-cols,107-example,204-example,206-random-wide}.stdin
+  do
+    CASE_NAME="export/$(basename ${CASE_STDIN_PATH%.*})${MODE:+ ($MODE)}"
+
+    # Keep the input open until the reader is done, so the segment still exists
+    touch $EXPORT_HOLD
+    (cat $CASE_STDIN_PATH; while [ -e $EXPORT_HOLD ]; do sleep 0.01; done) |
+      ./loesung $MODE --export=$EXPORT_NAME > $TEST_STDOUT &
+    if $EXPORT_READER $EXPORT_NAME $(grep -c '' $CASE_STDIN_PATH) | sort > $TEST_STDOUT.export && [ ${PIPESTATUS[0]} -eq 0 ]
+    then
+      rm $EXPORT_HOLD
+      wait
+      CASE_DIFF=$(diff <(sort $TEST_STDOUT) $TEST_STDOUT.export)
+    else
+      rm $EXPORT_HOLD
+      wait
+      CASE_DIFF="reader failed"
+    fi
+
+    # Check if diff empty
+    if [ "$CASE_DIFF" != "" ]
+    then
+      DIFF_DELTA="$(wc -l <<< "$CASE_DIFF")"
+      echo -e "\x1B[1;31m✕ Test $CASE_NAME\x1B[0m (Delta: $DIFF_DELTA)"
+      FAILED=$((FAILED + 1))
+    else
+      echo -e "\x1B[1;32m✓ Test $CASE_NAME\x1B[0m"
+    fi
+  done
 done
 
+rm $EXPORT_READER $TEST_STDOUT.export
+
 # Clean up
 rm $TEST_STDOUT
+
+# Fail if any test failed
+[ $FAILED -eq 0 ]
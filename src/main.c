@@ -1,23 +1,46 @@
-
 #define _GNU_SOURCE
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 // *****************
 // *   CONSTANTS   *
 // *****************
 
-// Initial and minimum column array size
-#define MIN_COL_SIZE 4
+// Number of pieces per column chunk (one removal mark bit per piece)
+#define COL_CHUNK_SIZE 64
+
+// Initial column chunk index size
+#define INITIAL_CHUNKS_SIZE 2
+
+// Number of pieces stored inline in the col node of small cols (at most 32)
+#define COL_INLINE_SIZE 8
+
+// Maximum number of pieces in a col (a multiple of COL_CHUNK_SIZE below the
+// padding tag)
+#define COL_MAX_SIZE 0x7fffffc0
+
+// Tag bit in the col count marking padding cols
+#define COL_PADDING_TAG 0x80000000u
 
 // Initial playground changes array size
 #define INITIAL_CHANGES_SIZE 8
 
-// Initial piece removal array size
-#define INITIAL_REMOVAL_SIZE 16
-
 // Empty piece value
 #define PIECE_EMPTY 255
 
@@ -27,6 +50,82 @@
 // Maximum absolute x value (1 digit more may not be able to fit into long)
 #define MAX_X 999999999
 
+// Number of moves per batch passed from the reader to the simulation thread
+#define PIPELINE_BATCH_SIZE 256
+
+// Number of batch slots in the reader to simulation thread queue
+#define PIPELINE_QUEUE_SIZE 64
+
+// Number of times a pipeline thread yields before waiting to be woken up
+#define PIPELINE_SPIN_COUNT 256
+
+// Cache line size used to pad data shared between threads
+#define CACHE_LINE_SIZE 64
+
+// Number of moves looked ahead in speculative mode
+#define SPECULATIVE_WINDOW_SIZE 4096
+
+// Maximum number of threads simulating shards in speculative mode
+#define SPECULATIVE_MAX_THREADS 16
+
+// Initial move array size of a batch game
+#define INITIAL_GAME_SIZE 64
+
+// Default memory budget of board snapshots in batch mode (in MiB)
+#define DEFAULT_SNAPSHOT_BUDGET 256
+
+// Number of cols at each shard bound that may depend on cols outside of it
+#define SHARD_GUARD_SIZE (MIN_LINE_COUNT - 1)
+
+// Initial distance between the outermost shard moves and the shard bounds
+#define SHARD_MARGIN (2 * SHARD_GUARD_SIZE)
+
+// Number of cols covered by the bitboard window (one bit per col)
+#define BITBOARD_WIDTH 64
+
+// Number of rows covered by the bitboard window
+#define BITBOARD_HEIGHT 64
+
+// Number of cols and rows at the bitboard window bounds lines may cross
+#define BITBOARD_GUARD_SIZE (MIN_LINE_COUNT - 1)
+
+// Minimum number of changed pieces of a round the bitboard detector pays off
+// for, fewer pieces are left to the scalar detector
+#define BITBOARD_MIN_CHANGES 16
+
+// Number of slots of the window col lookup table (power of 2)
+#define BITBOARD_SLOTS 256
+
+// Direction of row sweep heads walking the changed pieces of an isolated col
+#define SWEEP_WALK 2
+
+// Number of leading value bits distinguished by the latency histogram buckets
+// (relative bucket width of at most 1 / 2^LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_SUB_BUCKET_BITS 4
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+
+// Number of boards simulated at once in lockstep mode (vector size in bytes)
+#define LOCKSTEP_LANES 16
+
+// Number of cols and rows of each lockstep board
+#define LOCKSTEP_WIDTH 16
+#define LOCKSTEP_HEIGHT 16
+
+// Initial number of col directory entries and piece bytes of the board export
+#define EXPORT_INITIAL_COLS 1024
+#define EXPORT_INITIAL_PIECES (1 << 16)
+
+// Number of spare piece bytes reserved for each exported col to grow into
+#define EXPORT_COL_SLACK 8
+
+// Number of unrecorded and recorded repetitions of each microbenchmark
+#define BENCHMARK_WARMUP 3
+#define BENCHMARK_REPETITIONS 10
+
+// Number of latency histogram buckets covering all 64-bit values
+#define LATENCY_BUCKETS_COUNT \
+  ((64 - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS)
+
 // ********************
 // *   HEADER TYPES   *
 // ********************
@@ -34,43 +133,137 @@
 // Value range: [0, 254], 255 = cleared
 typedef unsigned char piece;
 
-// Col types
-typedef enum { COL_PIECES, COL_PADDING } colType;
+// Piece colors or counts of all lockstep lanes at the same cell
+typedef piece pieceLanes __attribute__((vector_size(LOCKSTEP_LANES)));
+
+// Per-lane flags (all bits set or unset) resulting from comparing pieceLanes
+typedef signed char laneMask __attribute__((vector_size(LOCKSTEP_LANES)));
+
+// Fixed-size part of a column
+struct Chunk {
+  // Bit y is set if piece y is marked to be removed in the current round
+  uint64_t removals;
+
+  // Chunk pieces
+  piece pieces[COL_CHUNK_SIZE];
+};
+
+// Reference to a chunk of a col
+union ChunkRef {
+  // Pointer to the chunk if the col is resident
+  struct Chunk* chunk;
+
+  // Backing file slot of the chunk if the col is evicted (out-of-core mode)
+  unsigned long slot;
+};
+
+// Chunk index of a col that outgrew its inline storage
+struct ChunkIndex {
+  // Number of chunk references fitting into the index
+  uint32_t size;
+
+  // Set if the chunks are held in memory, unset if they are evicted
+  bool resident;
+
+  // Move during which the col was last used (out-of-core mode)
+  unsigned long lastUse;
+
+  // Neighbours in the list of resident cols (out-of-core mode)
+  struct ChunkIndex* newer;
+  struct ChunkIndex* older;
+
+  // Col owning this index
+  struct Col* col;
+
+  // Piece y is stored at chunks[y / COL_CHUNK_SIZE] at offset
+  // y % COL_CHUNK_SIZE. Chunks never move, growing the col only allocates
+  // new chunks (and eventually grows the index).
+  union ChunkRef chunks[];
+};
+
+// Backing file storing evicted col chunks (out-of-core mode)
+struct ChunkStore {
+  // Backing file, NULL if out-of-core mode is disabled
+  FILE* file;
+  int fd;
+
+  // Number of slots of COL_CHUNK_SIZE pieces in the backing file
+  unsigned long slotsCount;
+
+  // Slots available for reuse
+  unsigned long* freeSlots;
+  unsigned long freeSlotsCount;
+  unsigned long freeSlotsSize;
+
+  // Maximum and current number of bytes held in memory by resident chunks and
+  // by chunk indexes (which stay in memory while their chunks are evicted)
+  unsigned long budget;
+  unsigned long residentSize;
+
+  // List of resident chunked cols ordered by last use
+  struct ChunkIndex* newest;
+  struct ChunkIndex* oldest;
+
+  // Number of completed moves
+  unsigned long clock;
+};
 
 // Col data structure
 struct Col {
-  // Col type
-  colType type;
+  // Pointer to next col
+  struct Col* next;
+
+  // Pointer to previous col
+  struct Col* prev;
 
   // Depending on the type:
-  // - DEFAULT: Number of pieces stacked on top of each other in this col
+  // - DEFAULT: Number of pieces fitting into the inline storage or the chunks
   // - PADDING: Number of padding cols between the previous and the next col
-  unsigned long size;
+  uint32_t size;
 
-  // Number of pieces that are part of the array
-  unsigned long count;
+  // Number of pieces stacked on top of each other in this col.
+  // Equal to COL_PADDING_TAG for padding cols.
+  uint32_t count;
 
   // Piece index above which changes were applied.
   // Equal to the col size if there are no changes.
-  unsigned long changeY;
-
-  // Pointer to next col
-  struct Col* next;
+  uint32_t changeY;
 
-  // Pointer to previous col
-  struct Col* prev;
+  // Bit y is set if inline piece y is marked to be removed
+  uint32_t removals;
 
-  // Column pieces
-  piece pieces[];
+  // Small cols (size equal to COL_INLINE_SIZE) store their pieces inline,
+  // larger cols reference a chunk index
+  union {
+    piece pieces[COL_INLINE_SIZE];
+    struct ChunkIndex* chunkIndex;
+  };
 };
 
-// Data structure describing a single piece removal from a referenced column
-struct PieceRemoval {
-  // Pointer to the col a piece should be removed from
-  struct Col *col;
-  
-  // Piece Y-position inside the reference col
+// Copy of the pieces inside a window of cols and rows around recent moves
+// allowing to test all window cols of a row at once (bitboard detection)
+struct Bitboard {
+  // Unset if the window needs to be rebuilt from the cols
+  bool valid;
+
+  // Position of the lower left window corner
+  long x;
   unsigned long y;
+
+  // X-position of the last placed piece the window gets moved to
+  long focusX;
+
+  // Window cols, NULL if not existing or padding
+  struct Col* cols[BITBOARD_WIDTH];
+
+  // Window col index + 1 by col address hash, 0 if the slot is empty. Slots
+  // of removed cols are left behind until the table is rebuilt.
+  uint8_t slots[BITBOARD_SLOTS];
+  unsigned long slotsCount;
+
+  // Piece colors by window row and col, PIECE_EMPTY if there is no piece.
+  // The extra row is kept empty for comparisons reading past the last row.
+  piece cells[BITBOARD_HEIGHT + 1][BITBOARD_WIDTH];
 };
 
 // Playground data structure (doubly linked list of cols)
@@ -101,10 +294,263 @@ struct Playground {
   unsigned long changedColsCount;
   unsigned long changedColsSize;
   
-  // Removals
-  struct PieceRemoval* pieceRemovals;
+  // Number of pieces marked to be removed in the current round
   unsigned long pieceRemovalsCount;
-  unsigned long pieceRemovalsSize;
+
+  // Shard guard cols (speculative mode). Changes to these cols may depend on
+  // cols outside of the shard and invalidate the shard simulation.
+  struct Col* guardCols[2 * SHARD_GUARD_SIZE];
+  unsigned long guardColsCount;
+  bool guardTouched;
+
+  // Bitboard window, NULL if bitboard detection is disabled
+  struct Bitboard* bitboard;
+
+  // Pieces to start sweeping rows and diagonals from (row sweep detection)
+  struct SweepHead* sweepHeads;
+  unsigned long sweepHeadsCount;
+  unsigned long sweepHeadsSize;
+
+  // Line pieces found by sweeps, marked once all sweeps are done (row sweep
+  // detection)
+  struct Mark* sweepMarks;
+  unsigned long sweepMarksCount;
+  unsigned long sweepMarksSize;
+
+  // Number of gravity rounds and changed cols of the last move
+  unsigned long cascadeDepth;
+  unsigned long cascadeColsCount;
+
+  // Board export the playground is published to, NULL if not exported
+  struct BoardExport* boardExport;
+};
+
+// Small boards of batch games simulated in lockstep (lockstep mode). Piece
+// (x, y) of lane i is stored at cells[y][x][i], so each operation on a cell
+// applies to the boards of all lanes at once.
+struct Lockstep {
+  // Piece colors, PIECE_EMPTY if there is no piece
+  pieceLanes cells[LOCKSTEP_HEIGHT][LOCKSTEP_WIDTH];
+
+  // Number of pieces per col
+  pieceLanes heights[LOCKSTEP_WIDTH];
+
+  // Game per lane, NULL if the lane is unused or spilled
+  struct Game* games[LOCKSTEP_LANES];
+
+  // X-position of col 0 per lane
+  long originX[LOCKSTEP_LANES];
+};
+
+// Header of the shared memory board export (export mode). It is followed by
+// the col directory of colsSize entries and the piece area.
+struct ExportHeader {
+  // Seqlock sequence number, odd while the board is being updated. Readers
+  // retry if it is odd or changed while they copied the board.
+  _Alignas(CACHE_LINE_SIZE) atomic_ulong sequence;
+
+  // Segment size in bytes. Readers need to map the segment again if it
+  // exceeds the size of their mapping.
+  unsigned long size;
+
+  // Number of completed moves
+  unsigned long movesCount;
+
+  // Number of used and available col directory entries
+  unsigned long colsCount;
+  unsigned long colsSize;
+
+  // Offset of the piece area from the segment start
+  unsigned long piecesOffset;
+};
+
+// Col directory entry of the board export, entries are ordered by x
+struct ExportCol {
+  // Col x-position
+  long x;
+
+  // Offset of the col pieces (bottom to top) inside the piece area
+  unsigned long offset;
+
+  // Number of pieces and of bytes reserved at the offset
+  unsigned long count;
+  unsigned long size;
+};
+
+// Writer state of the board export (export mode)
+struct BoardExport {
+  // Shared memory object name and descriptor
+  char* name;
+  int fd;
+
+  // Mapped segment
+  struct ExportHeader* header;
+  struct ExportCol* cols;
+  piece* pieces;
+
+  // Number of available and reserved bytes in the piece area
+  unsigned long piecesSize;
+  unsigned long piecesUsed;
+};
+
+// Log-bucketed histogram of move latencies in nanoseconds (latency mode)
+struct LatencyHistogram {
+  // Number of moves per bucket. Values below LATENCY_SUB_BUCKETS have their
+  // own bucket, larger values share a bucket with the values having the same
+  // magnitude and leading LATENCY_SUB_BUCKET_BITS bits.
+  unsigned long counts[LATENCY_BUCKETS_COUNT];
+
+  // Number of moves
+  unsigned long count;
+
+  // Highest latency
+  unsigned long max;
+};
+
+// Piece marked to be removed (bitboard check mode and row sweep detection)
+struct Mark {
+  struct Col* col;
+  unsigned long y;
+};
+
+// First changed piece of a run of adjacent changed pieces on a row or
+// diagonal (row sweep detection)
+struct SweepHead {
+  struct Col* col;
+  unsigned long y;
+
+  // Direction: falling diagonal (-1), horizontal (0), climbing diagonal (1)
+  // or SWEEP_WALK for the changed pieces of a col without changed neighbours
+  int delY;
+};
+
+// Single move parsed from an input line
+struct Move {
+  // Piece X-position
+  long x;
+
+  // Piece color
+  piece p;
+};
+
+// Batch of consecutive moves passed from the reader to the simulation thread
+struct MoveBatch {
+  // Number of moves in the batch
+  unsigned long count;
+
+  // Number of input lines read up to and including this batch
+  unsigned long lineNumber;
+
+  // Set if no more batches follow
+  bool last;
+
+  // Set if the input line following the batch moves is unexpected
+  bool invalid;
+
+  // Batch moves
+  struct Move moves[PIPELINE_BATCH_SIZE];
+};
+
+// Bounded single-producer/single-consumer ring buffer of move batches.
+// Head and tail are placed on separate cache lines to avoid false sharing.
+struct MoveQueue {
+  // Number of batches consumed by the simulation thread
+  _Alignas(CACHE_LINE_SIZE) atomic_ulong head;
+
+  // Number of batches published by the reader thread
+  _Alignas(CACHE_LINE_SIZE) atomic_ulong tail;
+
+  // Number of threads waiting to be woken up after spinning for too long
+  _Alignas(CACHE_LINE_SIZE) atomic_int sleepers;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+
+  // Batch slots
+  _Alignas(CACHE_LINE_SIZE) struct MoveBatch batches[PIPELINE_QUEUE_SIZE];
+};
+
+// Group of moves simulated on a copy of a board region (speculative mode)
+struct Shard {
+  // Region bounds
+  long lo;
+  long hi;
+
+  // Distance between the outermost shard moves and the region bounds
+  long margin;
+
+  // Indices of the shard moves (in input order)
+  unsigned long* moveIndices;
+  unsigned long movesCount;
+
+  // Shard playground with x-positions relative to lo, NULL if not simulated
+  struct Playground* playground;
+
+  // Set if the simulation reached the region bounds
+  bool conflict;
+};
+
+// Shards shared between worker threads (speculative mode)
+struct ShardWork {
+  // Playground the shard regions are copied from
+  struct Playground* source;
+
+  // Shards to be simulated
+  struct Shard* shards;
+  unsigned long shardsCount;
+
+  // Moves referenced by the shards
+  struct Move* moves;
+
+  // Index of the next shard to be taken by a worker thread
+  atomic_ulong next;
+};
+
+// Game read from an input file (batch mode)
+struct Game {
+  // Input file path
+  char* path;
+
+  // Game moves
+  struct Move* moves;
+  unsigned long movesCount;
+
+  // Unset if reading stopped at an unexpected line
+  bool validInput;
+};
+
+// Trie node representing a move prefix shared by games (batch mode)
+struct MoveNode {
+  // Last move of the prefix
+  struct Move move;
+
+  // Nodes of prefixes extended by one move
+  struct MoveNode* firstChild;
+  struct MoveNode* nextSibling;
+  unsigned long childCount;
+
+  // Number of games starting with, ending at and having played the prefix
+  unsigned long passCount;
+  unsigned long endCount;
+  unsigned long visitCount;
+
+  // Board after the prefix moves, NULL if not cached
+  struct Playground* snapshot;
+  unsigned long snapshotSize;
+
+  // Neighbours in the list of cached snapshots
+  struct MoveNode* newer;
+  struct MoveNode* older;
+};
+
+// Board snapshots ordered by last use (batch mode)
+struct SnapshotCache {
+  // Number of bytes held and allowed to be held by snapshots
+  unsigned long size;
+  unsigned long budget;
+
+  // Most and least recently used snapshot nodes
+  struct MoveNode* newest;
+  struct MoveNode* oldest;
 };
 
 // ************************
@@ -114,17 +560,123 @@ struct Playground {
 struct Playground* createPlayground(void);
 void freePlayground(struct Playground* playground);
 struct Col* createCol(void);
-struct Col* resizeCol(struct Playground* playground, struct Col* col, unsigned long size);
+void freeCol(struct Col* col);
+bool colIsPadding(struct Col* col);
+bool colIsInline(struct Col* col);
+void resizeCol(struct Col* col, unsigned long size);
+piece colGetPiece(struct Col* col, unsigned long y);
+void colSetPiece(struct Col* col, unsigned long y, piece p);
 struct Col* createPaddingCol(unsigned long size);
 struct Col* playgroundGetCol(struct Playground* playground, long x);
 void playgroundRemoveCol(struct Playground* playground, struct Col* col);
 void playgroundPlacePiece(struct Playground* playground, long x, piece p);
+bool colTouchesColor(struct Col* col, unsigned long y, piece p);
 void playgroundRemoveLines(struct Playground* playground);
+void playgroundRemoveLinesAt(struct Playground* playground, struct Col* col, unsigned long y);
+void playgroundWalkLines(struct Playground* playground);
+void playgroundCheckBitboardLines(struct Playground* playground);
+unsigned long playgroundCollectMarks(struct Playground* playground, struct Mark** marks);
+int compareMarks(const void* a, const void* b);
+bool colIsMarked(struct Col* col, unsigned long y);
+void colClearMarks(struct Col* col);
+void playgroundRemoveBitboardLines(struct Playground* playground);
+bool playgroundFocusBitboard(struct Playground* playground);
+void playgroundMoveBitboard(struct Playground* playground, long x, unsigned long y);
+void playgroundFillBitboard(struct Playground* playground, long from, long to);
+void bitboardPlacePiece(struct Bitboard* bitboard, long x, struct Col* col);
+void bitboardSetCol(struct Bitboard* bitboard, long i, struct Col* col);
+void bitboardCopyRows(struct Bitboard* bitboard, long i, long from, long to);
+void bitboardIndexCols(struct Bitboard* bitboard);
+void bitboardIndexCol(struct Bitboard* bitboard, long i);
+long bitboardColIndex(struct Bitboard* bitboard, struct Col* col);
+bool bitboardIsInner(struct Bitboard* bitboard, long i, long r);
+void bitboardUpdateCol(struct Bitboard* bitboard, struct Col* col, unsigned long fromY, unsigned long toY);
+uint64_t bitboardEqualMask(piece* a, piece* b);
+void playgroundRemoveSweepLines(struct Playground* playground);
+void playgroundSweepLine(struct Playground* playground, struct Col* col, unsigned long y, int delY);
+void playgroundAppendSweepHead(struct Playground* playground, struct Col* col, unsigned long y, int delY);
+void playgroundAppendSweepMark(struct Playground* playground, struct Col* col, unsigned long y);
+bool colIsChangedAt(struct Col* col, long y);
+bool colHasChangedNeighbour(struct Col* col);
+void playgroundPlaceTimedPiece(struct Playground* playground, long x, piece p, unsigned long lineNumber);
+unsigned long latencyBucket(unsigned long latency);
+unsigned long latencyBucketValue(unsigned long bucket);
+unsigned long latencyPercentile(struct LatencyHistogram* histogram, unsigned long permille);
+void latencyPrint(struct LatencyHistogram* histogram);
+void playgroundRemoveVerticalLines(struct Playground* playground, struct Col* col);
 void playgroundRemovePiece(struct Playground* playground, struct Col* col, unsigned long y);
 void playgroundTrackChange(struct Playground* playground, struct Col* col, unsigned long y);
+void playgroundTouchGuardCol(struct Playground* playground, struct Col* col);
 void playgroundCauseGravity(struct Playground* playground);
 void playgroundPrint(struct Playground* playground);
 void handleOutOfMemory(char description[]);
+bool parseMove(char* line, long lineLength, piece* p, long* x);
+bool parseMemorySize(char* value, unsigned long* size);
+bool parseMicroseconds(char* value, unsigned long* nanoseconds);
+bool playgroundRun(struct Playground* playground);
+bool playgroundRunPipeline(struct Playground* playground);
+void* moveQueueRead(void* arg);
+void moveQueueWait(struct MoveQueue* queue, atomic_ulong* counter, unsigned long value);
+void moveQueuePublish(struct MoveQueue* queue, atomic_ulong* counter, unsigned long value);
+bool playgroundRunSpeculative(struct Playground* playground);
+void playgroundPlaceMoves(struct Playground* playground, struct Move* moves, unsigned long movesCount);
+int compareMoveIndices(const void* a, const void* b);
+int compareShards(const void* a, const void* b);
+void shardMerge(struct Shard* shard, struct Shard* other);
+void shardsSimulate(struct Playground* source, struct Shard* shards, unsigned long shardsCount, struct Move* moves);
+void* shardsWork(void* arg);
+void shardSimulate(struct Shard* shard, struct Playground* source, struct Move* moves);
+void playgroundApplyShard(struct Playground* playground, struct Shard* shard);
+struct Col* playgroundSeekCol(struct Playground* playground, long x, long* colX);
+void playgroundClearChanges(struct Playground* playground);
+void colCopyPieces(struct Col* col, struct Col* source);
+void chunkStoreOpen(char* path, unsigned long budget);
+void chunkStoreClose(void);
+void chunkStoreTouch(struct Col* col);
+void chunkStoreLink(struct ChunkIndex* chunkIndex);
+void chunkStoreUnlink(struct ChunkIndex* chunkIndex);
+void chunkStoreFreeSlot(unsigned long slot);
+void chunkStoreEvict(void);
+void colPageOut(struct Col* col);
+void colPageIn(struct Col* col);
+bool playgroundRunBatch(char** paths, unsigned long gamesCount, unsigned long budget);
+void readGame(struct Game* game);
+int compareGames(const void* a, const void* b);
+struct MoveNode* createMoveNode(struct Move* move);
+struct MoveNode* moveNodeGetChild(struct MoveNode* node, struct Move* move);
+void freeMoveNode(struct SnapshotCache* cache, struct MoveNode* node);
+void snapshotCacheInsert(struct SnapshotCache* cache, struct MoveNode* node);
+void snapshotCacheTouch(struct SnapshotCache* cache, struct MoveNode* node);
+void snapshotCacheRemove(struct SnapshotCache* cache, struct MoveNode* node);
+struct Playground* clonePlayground(struct Playground* source, unsigned long* size);
+bool gameOpenOutput(struct Game* game);
+bool gameFitsLockstep(struct Game* game, long* originX);
+bool lockstepRun(struct Lockstep* lockstep, struct Game** games, unsigned long gamesCount);
+bool lockstepRemoveLines(struct Lockstep* lockstep);
+void lockstepCauseGravity(struct Lockstep* lockstep);
+struct Playground* lockstepSpill(struct Lockstep* lockstep, unsigned long lane);
+void lockstepPrint(struct Lockstep* lockstep, unsigned long lane);
+bool laneMaskAny(laneMask mask);
+void boardExportOpen(char* name);
+void boardExportClose(void);
+void boardExportResize(unsigned long colsSize, unsigned long piecesSize);
+void boardExportBegin(void);
+void boardExportEnd(void);
+bool boardExportCol(long x, struct Col* col);
+void playgroundExportMove(struct Playground* playground, struct Col* col, long x);
+void playgroundExportBoard(struct Playground* playground);
+void colExportPieces(struct Col* col, piece* pieces);
+void runBenchmarks(void);
+void benchmarkRun(char* name, unsigned long (*benchmark)(long, unsigned long), long param, unsigned long ops);
+unsigned long benchmarkClock(void);
+struct Playground* createBenchmarkPlayground(long width, long step, unsigned long height);
+unsigned long benchmarkGetCol(long distance, unsigned long ops);
+unsigned long benchmarkGetSparseCol(long distance, unsigned long ops);
+unsigned long benchmarkSeek(struct Playground* playground, long width, long distance, unsigned long ops);
+unsigned long benchmarkRemoveLines(long shape, unsigned long ops);
+unsigned long benchmarkCauseGravity(long interval, unsigned long ops);
+unsigned long benchmarkResizeCol(long count, unsigned long ops);
+unsigned long benchmarkPrint(long width, unsigned long ops);
 
 // ************
 // *   BODY   *
@@ -135,18 +687,186 @@ void handleOutOfMemory(char description[]);
  */
 bool debug = false;
 
+/**
+ * Global pipeline flag: Parse input on a separate reader thread
+ */
+bool pipeline = false;
+
+/**
+ * Global speculative flag: Simulate moves in independent regions concurrently
+ */
+bool speculative = false;
+
+/**
+ * Global bitboard flag: Detect lines near recent moves on row bitboards
+ */
+bool bitboardDetection = false;
+
+/**
+ * Global bitboard check flag: Cross-check bitboard detection against the
+ * scalar detector
+ */
+bool bitboardCheck = false;
+
+/**
+ * Global row sweep flag: Detect lines by sweeping rows and diagonals across
+ * adjacent changed cols
+ */
+bool rowSweep = false;
+
+/**
+ * Global lockstep flag: Simulate small batch games in groups of lanes
+ */
+bool lockstep = false;
+
+/**
+ * Global latency flag: Time each move and report latency percentiles
+ */
+bool measureLatency = false;
+
+/**
+ * Latency in nanoseconds above which moves are reported (latency mode)
+ */
+unsigned long slowMoveThreshold = ULONG_MAX;
+
+/**
+ * Global move latency histogram used in latency mode
+ */
+struct LatencyHistogram latency;
+
+/**
+ * Sink for values computed by microbenchmarks that would otherwise be
+ * optimized away
+ */
+volatile uintptr_t benchmarkSink;
+
+/**
+ * Global board export used in export mode
+ */
+struct BoardExport boardExport;
+
 /**
  * Global playground instance
  */
 struct Playground* playground;
 
+/**
+ * Global move queue used in pipeline mode
+ */
+struct MoveQueue moveQueue;
+
+/**
+ * Moves referenced by compareMoveIndices
+ */
+struct Move* sortMoves;
+
+/**
+ * Global backing file used in out-of-core mode
+ */
+struct ChunkStore chunkStore;
+
 /**
  * Main entry point
  * @return Exit code
  */
 int main(int argc, char *argv[]) {
+  // Parse command line options
+  bool benchmark = false;
+  char* exportName = NULL;
+  unsigned long memoryBudget = 0;
+  char* backingFile = NULL;
+  bool batch = false;
+  unsigned long snapshotBudget = (unsigned long) DEFAULT_SNAPSHOT_BUDGET << 20;
+  char** batchPaths = argv + argc;
+  for (int arg = 1; arg < argc; ++arg) {
+    if (strcmp(argv[arg], "--pipeline") == 0) {
+      pipeline = true;
+    } else if (strcmp(argv[arg], "--speculative") == 0) {
+      speculative = true;
+    } else if (strcmp(argv[arg], "--bitboard") == 0) {
+      bitboardDetection = true;
+    } else if (strcmp(argv[arg], "--bitboard-check") == 0) {
+      bitboardDetection = true;
+      bitboardCheck = true;
+    } else if (strcmp(argv[arg], "--row-sweep") == 0) {
+      rowSweep = true;
+    } else if (strcmp(argv[arg], "--latency") == 0) {
+      measureLatency = true;
+    } else if (strncmp(argv[arg], "--slow-move=", 12) == 0) {
+      measureLatency = true;
+      if (!parseMicroseconds(argv[arg] + 12, &slowMoveThreshold)) {
+        fprintf(stderr, "Invalid slow move threshold: %s\n", argv[arg] + 12);
+        exit(1);
+      }
+    } else if (strncmp(argv[arg], "--memory-budget=", 16) == 0) {
+      if (!parseMemorySize(argv[arg] + 16, &memoryBudget)) {
+        fprintf(stderr, "Invalid memory budget: %s\n", argv[arg] + 16);
+        exit(1);
+      }
+    } else if (strncmp(argv[arg], "--backing-file=", 15) == 0) {
+      backingFile = argv[arg] + 15;
+    } else if (strcmp(argv[arg], "--batch") == 0) {
+      // Remaining arguments are input file paths
+      batch = true;
+      batchPaths = argv + arg + 1;
+      break;
+    } else if (strncmp(argv[arg], "--export=", 9) == 0) {
+      exportName = argv[arg] + 9;
+    } else if (strcmp(argv[arg], "--benchmark") == 0) {
+      benchmark = true;
+    } else if (strcmp(argv[arg], "--lockstep") == 0) {
+      lockstep = true;
+    } else if (strncmp(argv[arg], "--snapshot-memory=", 18) == 0) {
+      if (!parseMemorySize(argv[arg] + 18, &snapshotBudget)) {
+        fprintf(stderr, "Invalid snapshot memory: %s\n", argv[arg] + 18);
+        exit(1);
+      }
+    } else {
+      fprintf(stderr, "Unknown option: %s\n", argv[arg]);
+      exit(1);
+    }
+  }
+
+  // Latency mode: Moves need to be placed one by one in input order
+  if (measureLatency && (speculative || batch)) {
+    fprintf(stderr, "Latency mode cannot be combined with --speculative or --batch\n");
+    exit(1);
+  }
+
+  // Export mode: Publish the board of a single game kept in memory
+  if (exportName && (batch || memoryBudget > 0 || backingFile)) {
+    fprintf(stderr, "Export mode cannot be combined with --batch or out-of-core mode\n");
+    exit(1);
+  }
+
+  // Out-of-core mode: Keep at most the given number of bytes of chunks and
+  // chunk indexes in memory
+  if (memoryBudget > 0 || backingFile) {
+    if (speculative) {
+      fprintf(stderr, "Out-of-core mode cannot be combined with --speculative\n");
+      exit(1);
+    }
+    chunkStoreOpen(backingFile, memoryBudget > 0 ? memoryBudget : ULONG_MAX);
+  }
+
+  // Benchmark mode: Measure core routines on in-process fixtures
+  if (benchmark) {
+    runBenchmarks();
+    chunkStoreClose();
+    return 0;
+  }
+
+  // Open the board export before allocating the playground, as failing to
+  // open it exits right away
+  if (exportName) {
+    boardExportOpen(exportName);
+  }
+  
   // Create empty playground
   playground = createPlayground();
+  if (exportName) {
+    playground->boardExport = &boardExport;
+  }
   
   // Debug mode: Run specific test case in debug mode if first argument is set
   /*
@@ -156,6 +876,106 @@ int main(int argc, char *argv[]) {
   }
   */
 
+  // Batch mode: Play each input file as a separate game
+  if (batch) {
+    bool validBatch = playgroundRunBatch(batchPaths, argv + argc - batchPaths,
+      snapshotBudget);
+    freePlayground(playground);
+    chunkStoreClose();
+    return validBatch ? 0 : 1;
+  }
+
+  bool validInput;
+  if (pipeline) {
+    validInput = playgroundRunPipeline(playground);
+  } else if (speculative) {
+    validInput = playgroundRunSpeculative(playground);
+  } else {
+    validInput = playgroundRun(playground);
+  }
+  
+  if (measureLatency) {
+    latencyPrint(&latency);
+  }
+  
+  // Handle unexpected input
+  if (!validInput) {
+    fprintf(stderr, "Unexpected input. Expected line format: ^[0-9]+ +-?[0-9]+$\n");
+    freePlayground(playground);
+    chunkStoreClose();
+    boardExportClose();
+    exit(1);
+  }
+
+  // Print playground to stout
+  playgroundPrint(playground);
+
+  // Dealloc used memory before quitting
+  freePlayground(playground);
+  chunkStoreClose();
+  boardExportClose();
+  return 0;
+}
+
+/**
+ * Parse a memory size given in MiB or with a K, M or G suffix (e.g. 512K).
+ * @param value Size characters
+ * @param size Pointer the number of bytes gets written to
+ * @return True, if the value is a positive size in the expected format
+ */
+bool parseMemorySize(char* value, unsigned long* size) {
+  // Expected format: ^[0-9]+[KMG]?$
+  if (*value < '0' || *value > '9') {
+    return false;
+  }
+  char* end;
+  unsigned long number = strtoul(value, &end, 10);
+  int shift = 20;
+  if (*end == 'K') {
+    shift = 10;
+    ++end;
+  } else if (*end == 'M') {
+    ++end;
+  } else if (*end == 'G') {
+    shift = 30;
+    ++end;
+  }
+  if (*end != '\0' || number == 0 || number > ULONG_MAX >> shift) {
+    return false;
+  }
+  *size = number << shift;
+  return true;
+}
+
+/**
+ * Parse a duration given in microseconds.
+ * @param value Duration characters
+ * @param nanoseconds Pointer the duration in nanoseconds gets written to
+ * @return True, if the value is a duration in the expected format
+ */
+bool parseMicroseconds(char* value, unsigned long* nanoseconds) {
+  // Expected format: ^[0-9]+$
+  if (*value < '0' || *value > '9') {
+    return false;
+  }
+  char* end;
+  unsigned long number = strtoul(value, &end, 10);
+  if (*end != '\0' || number > ULONG_MAX / 1000) {
+    return false;
+  }
+  *nanoseconds = number * 1000;
+  return true;
+}
+
+/**
+ * Parse a single input line into a move.
+ * @param line Line characters
+ * @param lineLength Number of line characters
+ * @param p Pointer the parsed piece color gets written to
+ * @param x Pointer the parsed x-position gets written to
+ * @return True, if the line matches the expected format
+ */
+bool parseMove(char* line, long lineLength, piece* p, long* x) {
   // Expected line format: ^[0-9]+ +-?[0-9]+$
   // Current line reading stage
   // -1 - Unexpected input
@@ -163,74 +983,91 @@ int main(int argc, char *argv[]) {
   //  1 - Reading spaces and optional -
   //  2 - Reading positive x value in [0; +2^21]
   //  3 - Reading negative x value in [-2^21; 0]
-  //  4 - No lines read
-  int readingStage = 4;
+  int readingStage = 0;
   
   // Value currently being read
   long argValue = 0;
   
-  // Read first line
-  char *line = NULL;
-  size_t lineSize = 32;
+  long i = -1;
+  int c;
+  
+  // Iterate through line characters
+  while (++i < lineLength && readingStage != -1) {
+    c = line[i];
+    if (c >= '0' && c <= '9') {
+      // Read decimal digit
+      if (readingStage == 1) {
+        // Move to positive x reading stage
+        readingStage = 2;
+      }
+      // Shift in decimal digit
+      argValue = argValue * 10 + (c - '0');
+      // Verify value bounds
+      if (argValue > MAX_X) {
+        readingStage = -1;
+      }
+    } else if (readingStage < 2 && c == ' ') {
+      // Move to spaces stage
+      readingStage = 1;
+       
+      if (argValue < PIECE_EMPTY) {
+        *p = argValue;
+        argValue = 0;
+      } else {
+        // Unexpected piece value
+        readingStage = -1;
+      }
+    } else if (readingStage == 1 && c == '-') {
+      // Move to negative x reading stage
+      readingStage = 3;
+    } else if (c == '\n') {
+      // Ignore newline characters
+    } else {
+      // Unexpected character
+      readingStage = -1;
+    }
+  }
+  
+  if (readingStage < 2) {
+    // Unexpected character
+    return false;
+  }
+  
+  // Set x position
+  *x = readingStage == 2 ? argValue : -argValue;
+  return true;
+}
+
+/**
+ * Read moves from stdin and place them one after another on the playground.
+ * @param playground Playground instance
+ * @return False, if the input contains an unexpected line
+ */
+bool playgroundRun(struct Playground* playground) {
+  // Read first line
+  char *line = NULL;
+  size_t lineSize = 32;
   long lineLength = getline(&line, &lineSize, stdin);
   
-  int i, c;
+  bool validInput = true;
   piece p = 0;
   long x = 0;
+  unsigned long lineNumber = 0;
   
   // Iterate through lines
   while (lineLength > 0) {
-    readingStage = 0;
-    argValue = 0;
-    i = -1;
-    
-    // Iterate through line characters
-    while (++i < lineLength && readingStage != -1) {
-      c = line[i];
-      if (c >= '0' && c <= '9') {
-        // Read decimal digit
-        if (readingStage == 1) {
-          // Move to positive x reading stage
-          readingStage = 2;
-        }
-        // Shift in decimal digit
-        argValue = argValue * 10 + (c - '0');
-        // Verify value bounds
-        if (argValue > MAX_X) {
-          readingStage = -1;
-        }
-      } else if (readingStage < 2 && c == ' ') {
-        // Move to spaces stage
-        readingStage = 1;
-         
-        if (argValue < PIECE_EMPTY) {
-          p = argValue;
-          argValue = 0;
-        } else {
-          // Unexpected piece value
-          readingStage = -1;
-        }
-      } else if (readingStage == 1 && c == '-') {
-        // Move to negative x reading stage
-        readingStage = 3;
-      } else if (c == '\n') {
-        // Ignore newline characters
-      } else {
-        // Unexpected character
-        readingStage = -1;
-      }
-    }
-    
-    if (readingStage < 2) {
-      // Unexpected character
+    ++lineNumber;
+    if (!parseMove(line, lineLength, &p, &x)) {
+      validInput = false;
       break;
     }
     
-    // Set x position
-    x = readingStage == 2 ? argValue : -argValue;
-    
     // Place piece p at x
-    playgroundPlacePiece(playground, x, p);
+    if (measureLatency) {
+      playgroundPlaceTimedPiece(playground, x, p, lineNumber);
+    } else {
+      playgroundPlacePiece(playground, x, p);
+    }
     
     if (debug) {
       playgroundPrint(playground);
@@ -242,636 +1079,3890 @@ int main(int argc, char *argv[]) {
   
   // Free line
   free(line);
-  
-  // Handle unexpected input
-  if (readingStage < 2) {
-    fprintf(stderr, "Unexpected input. Expected line format: ^[0-9]+ +-?[0-9]+$\n");
-    freePlayground(playground);
-    exit(1);
-  }
-
-  // Print playground to stout
-  playgroundPrint(playground);
-
-  // Dealloc used memory before quitting
-  freePlayground(playground);
-  return 0;
+  return validInput;
 }
 
 /**
- * Handle the event of running out of memory.
- * @param description Task at which the program ran out of memory
+ * Reader thread entry point: Parse moves from stdin and publish them to the
+ * move queue in batches. Stops at the end of input or at the first unexpected
+ * line, which is flagged on the last batch.
+ * @param arg Pointer to MoveQueue instance
+ * @return NULL
  */
-void handleOutOfMemory(char description[]) {
-  fprintf(stderr, "Not enough memory left to %s.\n", description);
-  freePlayground(playground);
-  playground = NULL;
-  exit(1);
+void* moveQueueRead(void* arg) {
+  struct MoveQueue* queue = (struct MoveQueue*) arg;
+  struct MoveBatch* batch;
+  
+  char *line = NULL;
+  size_t lineSize = 32;
+  long lineLength;
+  
+  unsigned long tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  unsigned long lineNumber = 0;
+  bool done = false;
+  
+  while (!done) {
+    // Wait for a free batch slot
+    moveQueueWait(queue, &queue->head, tail - PIPELINE_QUEUE_SIZE);
+    
+    // Fill batch until it is full, the input ends or reading the next line
+    // may block (no more input buffered), so slow input is not held back
+    batch = &queue->batches[tail % PIPELINE_QUEUE_SIZE];
+    batch->count = 0;
+    batch->last = false;
+    batch->invalid = false;
+    
+    while (batch->count < PIPELINE_BATCH_SIZE) {
+      if (batch->count > 0 && stdin->_IO_read_ptr == stdin->_IO_read_end) {
+        break;
+      }
+      lineLength = getline(&line, &lineSize, stdin);
+      if (lineLength <= 0) {
+        batch->last = true;
+        break;
+      }
+      
+      ++lineNumber;
+      struct Move* move = &batch->moves[batch->count];
+      if (!parseMove(line, lineLength, &move->p, &move->x)) {
+        batch->last = true;
+        batch->invalid = true;
+        break;
+      }
+      ++batch->count;
+    }
+    batch->lineNumber = lineNumber;
+    done = batch->last;
+    
+    // Publish batch to the simulation thread
+    moveQueuePublish(queue, &queue->tail, ++tail);
+  }
+  
+  free(line);
+  return NULL;
 }
 
 /**
- * Create empty playground (containing a single origin node).
- * Assumptions:
- * - Origin, start and end cols must not be of type padding
- * - Two adjancent padding cols are not allowed
- * @return Pointer to playground
+ * Wait for a queue counter to change, yielding a bounded number of times
+ * before sleeping until the other thread publishes a change.
+ * @param queue Move queue
+ * @param counter Queue head or tail
+ * @param value Counter value to wait to be left
  */
-struct Playground* createPlayground(void) {
-  struct Playground* playground = (struct Playground*) malloc(
-    sizeof(struct Playground));
-  if (!playground) {
-    handleOutOfMemory("create a playground");
+void moveQueueWait(struct MoveQueue* queue, atomic_ulong* counter, unsigned long value) {
+  for (int i = 0; i < PIPELINE_SPIN_COUNT; ++i) {
+    if (atomic_load_explicit(counter, memory_order_acquire) != value) {
+      return;
+    }
+    sched_yield();
   }
-
-  struct Col* col = createCol();
-  playground->originCol = col;
-  playground->startCol = col;
-  playground->startColX = 0;
-  playground->endCol = col;
-  playground->endColX = 0;
-  playground->currentCol = col;
-  playground->currentX = 0;
   
-  playground->changedColsSize = INITIAL_CHANGES_SIZE;
-  playground->changedColsCount = 0;
-  playground->changedCols = (struct Col**)
-    malloc(playground->changedColsSize * sizeof(struct Col*));
-  if (!playground->changedCols) {
-    handleOutOfMemory("create a playground");
+  // Announce sleeping before checking the counter again, so the publishing
+  // thread either sees a sleeper or the check sees the new value
+  pthread_mutex_lock(&queue->lock);
+  atomic_fetch_add(&queue->sleepers, 1);
+  while (atomic_load(counter) == value) {
+    pthread_cond_wait(&queue->wake, &queue->lock);
   }
-  
-  playground->pieceRemovalsSize = INITIAL_REMOVAL_SIZE;
-  playground->pieceRemovalsCount = 0;
-  playground->pieceRemovals = (struct PieceRemoval*)
-    malloc(playground->pieceRemovalsSize * sizeof(struct PieceRemoval));
-  if (!playground->pieceRemovals) {
-    handleOutOfMemory("create a playground");
+  atomic_fetch_sub(&queue->sleepers, 1);
+  pthread_mutex_unlock(&queue->lock);
+}
+
+/**
+ * Set a queue counter and wake up the other thread if it is sleeping.
+ * @param queue Move queue
+ * @param counter Queue head or tail
+ * @param value New counter value
+ */
+void moveQueuePublish(struct MoveQueue* queue, atomic_ulong* counter, unsigned long value) {
+  atomic_store(counter, value);
+  if (atomic_load(&queue->sleepers) > 0) {
+    pthread_mutex_lock(&queue->lock);
+    pthread_cond_broadcast(&queue->wake);
+    pthread_mutex_unlock(&queue->lock);
   }
-  
-  return playground;
 }
 
 /**
- * Frees a playground instance with all of its cols.
- * @param playground Playground instance to free
+ * Read moves from stdin on a separate reader thread and place them on the
+ * playground as they arrive, hiding I/O and parsing latency behind the
+ * simulation.
+ * @param playground Playground instance
+ * @return False, if the input contains an unexpected line
  */
-void freePlayground(struct Playground* playground) {
-  if (playground) {
-    // Free cols in playground
-    struct Col* col = playground->startCol;
-    struct Col* next;
-    while (col) {
-      next = col->next;
-      free(col);
-      col = next;
+bool playgroundRunPipeline(struct Playground* playground) {
+  struct MoveQueue* queue = &moveQueue;
+  struct MoveBatch* batch;
+  pthread_t reader;
+  
+  atomic_init(&queue->head, 0);
+  atomic_init(&queue->tail, 0);
+  atomic_init(&queue->sleepers, 0);
+  pthread_mutex_init(&queue->lock, NULL);
+  pthread_cond_init(&queue->wake, NULL);
+  if (pthread_create(&reader, NULL, moveQueueRead, queue) != 0) {
+    // Fall back to reading on the simulation thread
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->wake);
+    return playgroundRun(playground);
+  }
+  
+  unsigned long head = 0;
+  bool validInput = true;
+  bool done = false;
+  
+  while (!done) {
+    // Wait for the next batch to be published
+    moveQueueWait(queue, &queue->tail, head);
+    
+    // Place batch moves
+    batch = &queue->batches[head % PIPELINE_QUEUE_SIZE];
+    unsigned long lineNumber =
+      batch->lineNumber - batch->count - (batch->invalid ? 1 : 0);
+    for (unsigned long i = 0; i < batch->count; ++i) {
+      if (measureLatency) {
+        playgroundPlaceTimedPiece(playground, batch->moves[i].x,
+          batch->moves[i].p, ++lineNumber);
+      } else {
+        playgroundPlacePiece(playground, batch->moves[i].x, batch->moves[i].p);
+      }
+      
+      if (debug) {
+        playgroundPrint(playground);
+      }
     }
+    validInput = !batch->invalid;
+    done = batch->last;
     
-    // Free piece removal and change arrays
-    free(playground->changedCols);
-    free(playground->pieceRemovals);
-
-    // Free playground itself
-    free(playground);
+    // Hand batch slot back to the reader thread
+    moveQueuePublish(queue, &queue->head, ++head);
   }
+  
+  pthread_join(reader, NULL);
+  pthread_mutex_destroy(&queue->lock);
+  pthread_cond_destroy(&queue->wake);
+  return validInput;
 }
 
 /**
- * Create a col node with the default initial size.
- * @return Pointer to new col node
+ * Read moves from stdin in windows and place each window by simulating groups
+ * of moves in non-overlapping x-regions concurrently.
+ * @param playground Playground instance
+ * @return False, if the input contains an unexpected line
  */
-struct Col* createCol(void) {
-  struct Col* col = (struct Col*)
-    malloc(sizeof(struct Col) + sizeof(piece) * MIN_COL_SIZE);
-  if (!col) {
-    handleOutOfMemory("create a column");
+bool playgroundRunSpeculative(struct Playground* playground) {
+  struct Move* moves = (struct Move*)
+    malloc(SPECULATIVE_WINDOW_SIZE * sizeof(struct Move));
+  if (!moves) {
+    handleOutOfMemory("create a move window");
   }
-  col->type = COL_PIECES;
-  col->size = MIN_COL_SIZE;
-  col->count = 0;
-  col->changeY = MIN_COL_SIZE;
-  col->next = NULL;
-  col->prev = NULL;
-  return col;
+  
+  char *line = NULL;
+  size_t lineSize = 32;
+  long lineLength = 1;
+  
+  bool validInput = true;
+  unsigned long movesCount;
+  
+  while (lineLength > 0 && validInput) {
+    // Look ahead a window of moves
+    movesCount = 0;
+    while (movesCount < SPECULATIVE_WINDOW_SIZE) {
+      lineLength = getline(&line, &lineSize, stdin);
+      if (lineLength <= 0) {
+        break;
+      }
+      struct Move* move = &moves[movesCount];
+      if (!parseMove(line, lineLength, &move->p, &move->x)) {
+        validInput = false;
+        break;
+      }
+      ++movesCount;
+    }
+    
+    // Place the moves preceding the end of the window or an unexpected line
+    playgroundPlaceMoves(playground, moves, movesCount);
+  }
+  
+  free(line);
+  free(moves);
+  return validInput;
 }
 
 /**
- * Resize a col node to the given size.
- * @param playground Pointer to playground the col is situated in.
- * Needed to update the playground pointers to the resized col pointer.
- * @param col Pointer to col to be resized
- * @param size Size the col should be resized to
- * @return Pointer to resized col node
+ * Place the given moves with the same outcome as placing them one after
+ * another. Moves are grouped into shards by non-overlapping x-regions that
+ * get simulated concurrently on copies of the regions. Shards whose cascades
+ * reach their bounds get expanded, merged with the shards they overlap and
+ * simulated again. If all moves end up in a single shard they are replayed
+ * sequentially on the playground itself.
+ * @param playground Playground instance
+ * @param moves Moves to be placed in order
+ * @param movesCount Number of moves
  */
-struct Col* resizeCol(struct Playground* playground, struct Col* col, unsigned long size) {
-  if (size < MIN_COL_SIZE) {
-    size = MIN_COL_SIZE;
+void playgroundPlaceMoves(struct Playground* playground, struct Move* moves, unsigned long movesCount) {
+  unsigned long i, j;
+  
+  if (movesCount == 0) {
+    return;
   }
   
-  if (col->size == size) {
-    return col;
+  // Sort move indices by x-position
+  unsigned long* sortedIndices = (unsigned long*)
+    malloc(movesCount * sizeof(unsigned long));
+  struct Shard* shards = (struct Shard*)
+    malloc(movesCount * sizeof(struct Shard));
+  if (!sortedIndices || !shards) {
+    handleOutOfMemory("create shards");
+  }
+  for (i = 0; i < movesCount; ++i) {
+    sortedIndices[i] = i;
   }
+  sortMoves = moves;
+  qsort(sortedIndices, movesCount, sizeof(unsigned long), compareMoveIndices);
   
-  struct Col* resizedCol = (struct Col*)
-    realloc(col, sizeof(struct Col) + sizeof(piece) * size);
-  if (!resizedCol) {
-    handleOutOfMemory("resize a column");
+  // Group moves into shards with non-overlapping regions
+  unsigned long shardsCount = 0;
+  struct Shard* shard = NULL;
+  long x;
+  for (i = 0; i < movesCount; ++i) {
+    x = moves[sortedIndices[i]].x;
+    if (!shard || x - SHARD_MARGIN > shard->hi) {
+      shard = &shards[shardsCount++];
+      shard->lo = x - SHARD_MARGIN;
+      shard->margin = SHARD_MARGIN;
+      shard->moveIndices = NULL;
+      shard->movesCount = 0;
+      shard->playground = NULL;
+      shard->conflict = false;
+    }
+    shard->hi = x + SHARD_MARGIN;
+    ++shard->movesCount;
   }
   
-  // Update size and state
-  if (resizedCol->changeY == resizedCol->size) {
-    resizedCol->changeY = size;
+  if (shardsCount > 1) {
+    // Collect shard move indices in input order
+    for (i = 0; i < shardsCount; ++i) {
+      shards[i].moveIndices = (unsigned long*)
+        malloc(shards[i].movesCount * sizeof(unsigned long));
+      if (!shards[i].moveIndices) {
+        handleOutOfMemory("create shards");
+      }
+      shards[i].movesCount = 0;
+    }
+    for (i = 0; i < movesCount; ++i) {
+      // Binary search the shard containing the move
+      unsigned long lower = 0;
+      unsigned long upper = shardsCount;
+      while (upper - lower > 1) {
+        j = (lower + upper) / 2;
+        if (shards[j].lo <= moves[i].x) {
+          lower = j;
+        } else {
+          upper = j;
+        }
+      }
+      shard = &shards[lower];
+      shard->moveIndices[shard->movesCount++] = i;
+    }
   }
-  resizedCol->size = size;
+  free(sortedIndices);
   
-  // Update pointers
-  if (resizedCol->next) {
-    resizedCol->next->prev = resizedCol;
-  } else {
-    playground->endCol = resizedCol;
+  while (shardsCount > 1) {
+    // Simulate shards that have not been simulated, yet
+    shardsSimulate(playground, shards, shardsCount, moves);
+    
+    // Expand shards whose cascades reached their bounds
+    bool conflict = false;
+    for (i = 0; i < shardsCount; ++i) {
+      shard = &shards[i];
+      if (shard->conflict) {
+        freePlayground(shard->playground);
+        shard->playground = NULL;
+        shard->conflict = false;
+        shard->lo -= shard->margin;
+        shard->hi += shard->margin;
+        shard->margin *= 2;
+        conflict = true;
+      }
+    }
+    
+    if (!conflict) {
+      break;
+    }
+    
+    // Merge overlapping shards, preserving the input order of their moves
+    qsort(shards, shardsCount, sizeof(struct Shard), compareShards);
+    j = 0;
+    for (i = 1; i < shardsCount; ++i) {
+      if (shards[i].lo <= shards[j].hi) {
+        shardMerge(&shards[j], &shards[i]);
+      } else {
+        shards[++j] = shards[i];
+      }
+    }
+    shardsCount = j + 1;
   }
-  if (resizedCol->prev) {
-    resizedCol->prev->next = resizedCol;
+  
+  if (shardsCount == 1) {
+    // Replay moves sequentially
+    freePlayground(shards[0].playground);
+    free(shards[0].moveIndices);
+    for (i = 0; i < movesCount; ++i) {
+      playgroundPlacePiece(playground, moves[i].x, moves[i].p);
+    }
   } else {
-    playground->startCol = resizedCol;
-  }
-  if (col == playground->originCol) {
-    playground->originCol = resizedCol;
-  }
-  if (col == playground->currentCol) {
-    playground->currentCol = resizedCol;
+    // Apply non-conflicting shard results to the playground
+    for (i = 0; i < shardsCount; ++i) {
+      playgroundApplyShard(playground, &shards[i]);
+      freePlayground(shards[i].playground);
+      free(shards[i].moveIndices);
+    }
+    
+    if (playground->boardExport) {
+      boardExportBegin();
+      playgroundExportBoard(playground);
+      boardExport.header->movesCount += movesCount;
+      boardExportEnd();
+    }
   }
-  return resizedCol;
+  
+  free(shards);
 }
 
 /**
- * Create a padding col node with the given size.
- * @param size Number of padding cols
- * @return Pointer to new col node
+ * Compare move indices by the x-position of the referenced moves.
+ * @param a Pointer to first move index
+ * @param b Pointer to second move index
+ * @return Comparison result
  */
-struct Col* createPaddingCol(unsigned long size) {
-  struct Col* col = (struct Col*) malloc(sizeof(struct Col));
-  if (!col) {
-    handleOutOfMemory("create a padding column");
-  }
-  col->type = COL_PADDING;
-  col->size = size;
-  col->next = NULL;
-  col->prev = NULL;
-  return col;
+int compareMoveIndices(const void* a, const void* b) {
+  long xa = sortMoves[*(const unsigned long*) a].x;
+  long xb = sortMoves[*(const unsigned long*) b].x;
+  return (xa > xb) - (xa < xb);
 }
 
 /**
- * Insert a piece at the given x-position.
- * @param playground Playground instance
- * @param x Position to insert the piece
- * @param p Piece color to be inserted
+ * Compare shards by their lower region bound.
+ * @param a Pointer to first shard
+ * @param b Pointer to second shard
+ * @return Comparison result
  */
-void playgroundPlacePiece(struct Playground* playground, long x, piece p) {
-  struct Col* col = playgroundGetCol(playground, x);
-
-  // Dynamically increase col size if necessary
-  if (col->count == col->size) {
-    col = resizeCol(playground, col, col->size * 2);
-  }
-
-  // Append piece to the top of the col stack
-  col->pieces[col->count] = p;
-  playgroundTrackChange(playground, col, col->count);
-  ++col->count;
+int compareShards(const void* a, const void* b) {
+  long loA = ((const struct Shard*) a)->lo;
+  long loB = ((const struct Shard*) b)->lo;
+  return (loA > loB) - (loA < loB);
+}
 
-  // Scan for lines, remove them, cause gravity and repeat the process until no
-  // more lines are being identified
-  playgroundRemoveLines(playground);
-  while (playground->pieceRemovalsCount > 0) {
-    playgroundCauseGravity(playground);
-    playgroundRemoveLines(playground);
+/**
+ * Merge the moves and the region of a shard into another one. Both shards
+ * are reset to be simulated again.
+ * @param shard Shard to merge into
+ * @param other Shard to be merged, its moves are freed
+ */
+void shardMerge(struct Shard* shard, struct Shard* other) {
+  unsigned long* moveIndices = (unsigned long*) malloc(
+    (shard->movesCount + other->movesCount) * sizeof(unsigned long));
+  if (!moveIndices) {
+    handleOutOfMemory("merge shards");
   }
-
-  // Reset change state and memory optimization (col shrinking and removal)
-  for (unsigned long i = 0; i < playground->changedColsCount; ++i) {
-    col = playground->changedCols[i];
-    if (col->count == 0 && col != playground->originCol) {
-      // Found empty column not being at the origin, remove it
-      playgroundRemoveCol(playground, col);
-    } else if (col->size > MIN_COL_SIZE && col->count * 4 < col->size) {
-      // Reset change state and shrink col
-      col->changeY = col->size;
-      col = resizeCol(playground, col, col->size / 4);
+  
+  // Merge move indices keeping them in input order
+  unsigned long i = 0, j = 0, k = 0;
+  while (i < shard->movesCount || j < other->movesCount) {
+    if (j == other->movesCount ||
+        (i < shard->movesCount &&
+          shard->moveIndices[i] < other->moveIndices[j])) {
+      moveIndices[k++] = shard->moveIndices[i++];
     } else {
-      // Reset change state
-      col->changeY = col->size;
+      moveIndices[k++] = other->moveIndices[j++];
     }
   }
   
-  // Clear changes
-  playground->changedColsCount = 0;
+  free(shard->moveIndices);
+  free(other->moveIndices);
+  freePlayground(shard->playground);
+  freePlayground(other->playground);
+  
+  shard->moveIndices = moveIndices;
+  shard->movesCount = k;
+  shard->playground = NULL;
+  if (other->hi > shard->hi) {
+    shard->hi = other->hi;
+  }
+  if (other->margin > shard->margin) {
+    shard->margin = other->margin;
+  }
 }
 
 /**
- * Finds the Col at the given x. Lazily creates a col instance if not done, yet.
- * Lazily creates padding cols if necessary, but they are never returned.
- * Inside this method make sure the linked list stays intact between creation
- * calls to ensure the list can be freed up, again.
- * @param playground Playground instance
- * @param x Col position
- * @return Pointer to Col struct
+ * Simulate all shards without a shard playground on worker threads.
+ * @param source Playground the shard regions are copied from (read-only)
+ * @param shards Shards
+ * @param shardsCount Number of shards
+ * @param moves Moves referenced by the shards
  */
-struct Col* playgroundGetCol(struct Playground* playground, long x) {
-  struct Col* col;
+void shardsSimulate(struct Playground* source, struct Shard* shards, unsigned long shardsCount, struct Move* moves) {
+  struct ShardWork work;
+  work.source = source;
+  work.shards = shards;
+  work.shardsCount = shardsCount;
+  work.moves = moves;
+  atomic_init(&work.next, 0);
   
-  // Test basic search cases (cheap, in O(1))
-  if (x == 0) {
-    // Origin col requested
-    return playground->originCol;
-
-  } else if (x == playground->endColX) {
-    // End col requested
+  long threadsCount = sysconf(_SC_NPROCESSORS_ONLN);
+  if (threadsCount > SPECULATIVE_MAX_THREADS) {
+    threadsCount = SPECULATIVE_MAX_THREADS;
+  }
+  if (threadsCount > (long) shardsCount) {
+    threadsCount = shardsCount;
+  }
+  
+  // The current thread takes part in the work, too
+  pthread_t threads[SPECULATIVE_MAX_THREADS];
+  long i, startedCount = 0;
+  for (i = 1; i < threadsCount; ++i) {
+    if (pthread_create(&threads[startedCount], NULL, shardsWork, &work) == 0) {
+      ++startedCount;
+    }
+  }
+  shardsWork(&work);
+  for (i = 0; i < startedCount; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+}
+
+/**
+ * Worker thread entry point: Simulate shards until no shard is left.
+ * @param arg Pointer to ShardWork instance
+ * @return NULL
+ */
+void* shardsWork(void* arg) {
+  struct ShardWork* work = (struct ShardWork*) arg;
+  unsigned long i;
+  while ((i = atomic_fetch_add(&work->next, 1)) < work->shardsCount) {
+    if (!work->shards[i].playground) {
+      shardSimulate(&work->shards[i], work->source, work->moves);
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Copy the shard region from the source playground to a new shard playground
+ * and place the shard moves on it. Flags a conflict if a change reaches the
+ * guard cols at the region bounds, as such a change may depend on cols
+ * outside the region.
+ * @param shard Shard to simulate
+ * @param source Playground the shard region is copied from (read-only)
+ * @param moves Moves referenced by the shard
+ */
+void shardSimulate(struct Shard* shard, struct Playground* source, struct Move* moves) {
+  struct Playground* playground = createPlayground();
+  struct Col* col;
+  long x;
+  
+  // Copy region cols
+  struct Col* sourceCol = playgroundSeekCol(source, shard->lo, &x);
+  while (sourceCol && x <= shard->hi) {
+    if (!colIsPadding(sourceCol)) {
+      if (x >= shard->lo && sourceCol->count > 0) {
+        col = playgroundGetCol(playground, x - shard->lo);
+        colCopyPieces(col, sourceCol);
+        
+        // Register guard cols
+        if (x < shard->lo + SHARD_GUARD_SIZE ||
+            x > shard->hi - SHARD_GUARD_SIZE) {
+          playground->guardCols[playground->guardColsCount++] = col;
+        }
+      }
+      ++x;
+    } else {
+      x += sourceCol->size;
+    }
+    sourceCol = sourceCol->next;
+  }
+  
+  // Place shard moves
+  for (unsigned long i = 0; i < shard->movesCount; ++i) {
+    struct Move* move = &moves[shard->moveIndices[i]];
+    playgroundPlacePiece(playground, move->x - shard->lo, move->p);
+    if (playground->guardTouched) {
+      break;
+    }
+  }
+  
+  shard->playground = playground;
+  shard->conflict = playground->guardTouched;
+}
+
+/**
+ * Replace the shard region of the playground by the simulated shard cols.
+ * @param playground Playground instance
+ * @param shard Simulated shard
+ */
+void playgroundApplyShard(struct Playground* playground, struct Shard* shard) {
+  struct Playground* shardPlayground = shard->playground;
+  struct Col* shardCol = shardPlayground->startCol;
+  long shardX = shard->lo + shardPlayground->startColX;
+  long x;
+  
+  // Update or clear existing region cols
+  struct Col* col = playgroundSeekCol(playground, shard->lo, &x);
+  while (col && x <= shard->hi) {
+    if (!colIsPadding(col)) {
+      if (x >= shard->lo && col->count > 0) {
+        // Move to the shard col at the same position
+        while (shardCol && shardX < x) {
+          shardX += colIsPadding(shardCol) ? shardCol->size : 1;
+          shardCol = shardCol->next;
+        }
+        
+        playgroundTrackChange(playground, col, 0);
+        if (shardCol && shardX == x && !colIsPadding(shardCol)) {
+          colCopyPieces(col, shardCol);
+          shardCol->count = 0;
+        } else {
+          col->count = 0;
+        }
+      }
+      ++x;
+    } else {
+      x += col->size;
+    }
+    col = col->next;
+  }
+  
+  // Create cols that only exist in the shard
+  shardCol = shardPlayground->startCol;
+  shardX = shard->lo + shardPlayground->startColX;
+  while (shardCol) {
+    if (!colIsPadding(shardCol)) {
+      if (shardCol->count > 0) {
+        col = playgroundGetCol(playground, shardX);
+        playgroundTrackChange(playground, col, 0);
+        colCopyPieces(col, shardCol);
+      }
+      ++shardX;
+    } else {
+      shardX += shardCol->size;
+    }
+    shardCol = shardCol->next;
+  }
+  
+  // Remove emptied cols, the bitboard window is rebuilt on the next
+  // detection round using it
+  if (playground->bitboard) {
+    playground->bitboard->valid = false;
+  }
+  playgroundClearChanges(playground);
+}
+
+/**
+ * Play a batch of games, each read from its own input file. Shared move
+ * prefixes are organized in a trie and the board is snapshotted at branch
+ * points, so games resume from the deepest cached snapshot instead of the
+ * empty playground. Each resulting board is written to the input file path
+ * with an appended ".out".
+ * @param paths Input file paths
+ * @param gamesCount Number of input files
+ * @param budget Maximum number of bytes held by snapshots
+ * @return False, if any of the games contains an unexpected line
+ */
+bool playgroundRunBatch(char** paths, unsigned long gamesCount, unsigned long budget) {
+  unsigned long i, j;
+  bool validInput = true;
+  
+  struct Game* games = (struct Game*) malloc(gamesCount * sizeof(struct Game));
+  struct Game** sortedGames = (struct Game**)
+    malloc(gamesCount * sizeof(struct Game*));
+  struct MoveNode* root = createMoveNode(NULL);
+  if (!games || !sortedGames) {
+    handleOutOfMemory("create a batch");
+  }
+  
+  // Read games
+  for (i = 0; i < gamesCount; ++i) {
+    games[i].path = paths[i];
+    readGame(&games[i]);
+  }
+  
+  // Lockstep mode: Simulate games fitting the lockstep boards in groups of
+  // lanes, leave the other games to the trie
+  unsigned long trieGamesCount = 0;
+  if (lockstep) {
+    struct Lockstep* lockstepBoards = (struct Lockstep*)
+      aligned_alloc(sizeof(pieceLanes), sizeof(struct Lockstep));
+    if (!lockstepBoards) {
+      handleOutOfMemory("create a batch");
+    }
+    struct Game* laneGames[LOCKSTEP_LANES];
+    unsigned long lanesCount = 0;
+    long originX;
+    for (i = 0; i < gamesCount; ++i) {
+      if (gameFitsLockstep(&games[i], &originX)) {
+        laneGames[lanesCount++] = &games[i];
+        if (lanesCount == LOCKSTEP_LANES) {
+          validInput &= lockstepRun(lockstepBoards, laneGames, lanesCount);
+          lanesCount = 0;
+        }
+      } else {
+        sortedGames[trieGamesCount++] = &games[i];
+      }
+    }
+    if (lanesCount > 0) {
+      validInput &= lockstepRun(lockstepBoards, laneGames, lanesCount);
+    }
+    free(lockstepBoards);
+  } else {
+    for (i = 0; i < gamesCount; ++i) {
+      sortedGames[trieGamesCount++] = &games[i];
+    }
+  }
+  
+  // Insert game moves into the trie
+  for (i = 0; i < trieGamesCount; ++i) {
+    struct MoveNode* node = root;
+    ++node->passCount;
+    for (j = 0; j < sortedGames[i]->movesCount; ++j) {
+      node = moveNodeGetChild(node, &sortedGames[i]->moves[j]);
+      ++node->passCount;
+    }
+    ++node->endCount;
+  }
+  
+  // Play games in trie order to reuse snapshots while they are cached
+  qsort(sortedGames, trieGamesCount, sizeof(struct Game*), compareGames);
+  
+  struct SnapshotCache cache;
+  cache.size = 0;
+  cache.budget = budget;
+  cache.newest = NULL;
+  cache.oldest = NULL;
+  
+  for (i = 0; i < trieGamesCount; ++i) {
+    struct Game* game = sortedGames[i];
+    
+    // Find the deepest cached snapshot on the game path
+    struct MoveNode* node = root;
+    struct MoveNode* resumeNode = root;
+    unsigned long resumeIndex = 0;
+    ++node->visitCount;
+    for (j = 0; j < game->movesCount; ++j) {
+      node = moveNodeGetChild(node, &game->moves[j]);
+      ++node->visitCount;
+      if (node->snapshot) {
+        resumeNode = node;
+        resumeIndex = j + 1;
+      }
+    }
+    
+    // Resume from the snapshot
+    freePlayground(playground);
+    if (resumeNode->snapshot) {
+      playground = clonePlayground(resumeNode->snapshot, NULL);
+      snapshotCacheTouch(&cache, resumeNode);
+    } else {
+      playground = createPlayground();
+    }
+    
+    // Place the remaining moves, snapshotting at branch points still ahead of
+    // other games
+    node = resumeNode;
+    for (j = resumeIndex; j < game->movesCount; ++j) {
+      playgroundPlacePiece(playground, game->moves[j].x, game->moves[j].p);
+      node = moveNodeGetChild(node, &game->moves[j]);
+      if (
+        !node->snapshot &&
+        node->visitCount < node->passCount &&
+        (node->childCount > 1 || (node->childCount > 0 && node->endCount > 0))
+      ) {
+        node->snapshot = clonePlayground(playground, &node->snapshotSize);
+        snapshotCacheInsert(&cache, node);
+      }
+    }
+    
+    // Drop snapshots no other game passes anymore
+    node = root;
+    for (j = 0; j < game->movesCount; ++j) {
+      node = moveNodeGetChild(node, &game->moves[j]);
+      if (node->snapshot && node->visitCount == node->passCount) {
+        snapshotCacheRemove(&cache, node);
+      }
+    }
+    
+    if (!game->validInput) {
+      validInput = false;
+      continue;
+    }
+    
+    // Write resulting board
+    if (gameOpenOutput(game)) {
+      playgroundPrint(playground);
+      fflush(stdout);
+    } else {
+      validInput = false;
+    }
+  }
+  
+  // Release trie and games
+  freeMoveNode(&cache, root);
+  for (i = 0; i < gamesCount; ++i) {
+    free(games[i].moves);
+  }
+  free(sortedGames);
+  free(games);
+  return validInput;
+}
+
+/**
+ * Redirect stdout to the output file of a batch game, being the input file
+ * path with an appended ".out".
+ * @param game Batch game
+ * @return False, if the output file cannot be written
+ */
+bool gameOpenOutput(struct Game* game) {
+  char* outputPath = (char*) malloc(strlen(game->path) + 5);
+  if (!outputPath) {
+    handleOutOfMemory("write a batch result");
+  }
+  strcpy(outputPath, game->path);
+  strcat(outputPath, ".out");
+  bool opened = freopen(outputPath, "w", stdout) != NULL;
+  if (!opened) {
+    fprintf(stderr, "Unable to write %s.\n", outputPath);
+  }
+  free(outputPath);
+  return opened;
+}
+
+/**
+ * Check whether the moves of a batch game fit into the cols of a lockstep
+ * board.
+ * @param game Batch game
+ * @param originX Pointer the x-position of the lowest game col gets written to
+ * @return True, if the game spans at most LOCKSTEP_WIDTH cols
+ */
+bool gameFitsLockstep(struct Game* game, long* originX) {
+  long minX = 0;
+  long maxX = 0;
+  for (unsigned long j = 0; j < game->movesCount; ++j) {
+    if (j == 0 || game->moves[j].x < minX) {
+      minX = game->moves[j].x;
+    }
+    if (j == 0 || game->moves[j].x > maxX) {
+      maxX = game->moves[j].x;
+    }
+  }
+  *originX = minX;
+  return maxX - minX < LOCKSTEP_WIDTH;
+}
+
+/**
+ * Play a group of batch games in lockstep, one game per lane, and write their
+ * resulting boards. Each step places the next move of every lane, then lines
+ * are removed and gravity is caused on all lanes at once until no lane has
+ * lines left. A lane whose col outgrows the board height is spilled to a
+ * playground that plays the remaining moves of its game.
+ * @param lockstep Lockstep boards
+ * @param games Games fitting the lockstep board width
+ * @param gamesCount Number of games, at most LOCKSTEP_LANES
+ * @return False, if any of the games contains an unexpected line
+ */
+bool lockstepRun(struct Lockstep* lockstep, struct Game** games, unsigned long gamesCount) {
+  bool validInput = true;
+  unsigned long movesCount = 0;
+  unsigned long lane, j;
+  struct Game* game;
+  
+  memset(lockstep->cells, PIECE_EMPTY, sizeof(lockstep->cells));
+  memset(lockstep->heights, 0, sizeof(lockstep->heights));
+  for (lane = 0; lane < LOCKSTEP_LANES; ++lane) {
+    lockstep->games[lane] = lane < gamesCount ? games[lane] : NULL;
+    if (lane < gamesCount) {
+      gameFitsLockstep(games[lane], &lockstep->originX[lane]);
+      if (games[lane]->movesCount > movesCount) {
+        movesCount = games[lane]->movesCount;
+      }
+    }
+  }
+  
+  for (j = 0; j < movesCount; ++j) {
+    // Place the next move of each lane
+    for (lane = 0; lane < gamesCount; ++lane) {
+      game = lockstep->games[lane];
+      if (!game || j >= game->movesCount) {
+        continue;
+      }
+      
+      struct Move* move = &game->moves[j];
+      long x = move->x - lockstep->originX[lane];
+      piece y = lockstep->heights[x][lane];
+      if (y == LOCKSTEP_HEIGHT) {
+        // Spill the lane to the regular engine
+        struct Playground* playground = lockstepSpill(lockstep, lane);
+        for (unsigned long k = j; k < game->movesCount; ++k) {
+          playgroundPlacePiece(playground, game->moves[k].x, game->moves[k].p);
+        }
+        if (!game->validInput) {
+          validInput = false;
+        } else if (gameOpenOutput(game)) {
+          playgroundPrint(playground);
+          fflush(stdout);
+        } else {
+          validInput = false;
+        }
+        freePlayground(playground);
+        lockstep->games[lane] = NULL;
+        continue;
+      }
+      lockstep->cells[y][x][lane] = move->p;
+      lockstep->heights[x][lane] = y + 1;
+    }
+    
+    // Resolve lines in all lanes
+    while (lockstepRemoveLines(lockstep)) {
+      lockstepCauseGravity(lockstep);
+    }
+  }
+  
+  // Write resulting boards
+  for (lane = 0; lane < gamesCount; ++lane) {
+    game = lockstep->games[lane];
+    if (!game) {
+      continue;
+    }
+    if (!game->validInput) {
+      validInput = false;
+    } else if (gameOpenOutput(game)) {
+      lockstepPrint(lockstep, lane);
+      fflush(stdout);
+    } else {
+      validInput = false;
+    }
+  }
+  return validInput;
+}
+
+/**
+ * Identify lines in all directions on the boards of all lanes and remove
+ * their pieces.
+ * @param lockstep Lockstep boards
+ * @return True, if any lane had pieces on lines
+ */
+bool lockstepRemoveLines(struct Lockstep* lockstep) {
+  // Directions horizontal (–), vertical (|), climbing (/) and falling (\)
+  // diagonal as x and y steps
+  static const int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+  
+  laneMask marks[LOCKSTEP_HEIGHT][LOCKSTEP_WIDTH];
+  laneMask any = {0};
+  laneMask line;
+  pieceLanes current;
+  memset(marks, 0, sizeof(marks));
+  
+  for (int y = 0; y < LOCKSTEP_HEIGHT; ++y) {
+    for (int x = 0; x < LOCKSTEP_WIDTH; ++x) {
+      current = lockstep->cells[y][x];
+      for (int d = 0; d < 4; ++d) {
+        int delX = directions[d][0];
+        int delY = directions[d][1];
+        int endX = x + delX * (MIN_LINE_COUNT - 1);
+        int endY = y + delY * (MIN_LINE_COUNT - 1);
+        if (endX >= LOCKSTEP_WIDTH || endY < 0 || endY >= LOCKSTEP_HEIGHT) {
+          continue;
+        }
+        
+        // Lanes having a line of pieces starting at (x, y)
+        line = current != PIECE_EMPTY;
+        for (int k = 1; k < MIN_LINE_COUNT; ++k) {
+          line &= lockstep->cells[y + k * delY][x + k * delX] == current;
+        }
+        for (int k = 0; k < MIN_LINE_COUNT; ++k) {
+          marks[y + k * delY][x + k * delX] |= line;
+        }
+        any |= line;
+      }
+    }
+  }
+  
+  if (!laneMaskAny(any)) {
+    return false;
+  }
+  
+  // Remove marked pieces (PIECE_EMPTY has all bits set)
+  for (int y = 0; y < LOCKSTEP_HEIGHT; ++y) {
+    for (int x = 0; x < LOCKSTEP_WIDTH; ++x) {
+      lockstep->cells[y][x] |= (pieceLanes) marks[y][x];
+    }
+  }
+  return true;
+}
+
+/**
+ * Let pieces fall into the gaps left by removed pieces on the boards of all
+ * lanes and update the col heights.
+ * @param lockstep Lockstep boards
+ */
+void lockstepCauseGravity(struct Lockstep* lockstep) {
+  laneMask moved;
+  laneMask gap;
+  
+  for (int x = 0; x < LOCKSTEP_WIDTH; ++x) {
+    // Move pieces above gaps down by one row per pass until all have settled
+    do {
+      moved = (laneMask) {0};
+      for (int y = LOCKSTEP_HEIGHT - 2; y >= 0; --y) {
+        pieceLanes* below = &lockstep->cells[y][x];
+        pieceLanes* above = &lockstep->cells[y + 1][x];
+        gap = (*below == PIECE_EMPTY) & (*above != PIECE_EMPTY);
+        *below = (*below & ~(pieceLanes) gap) | (*above & (pieceLanes) gap);
+        *above |= (pieceLanes) gap;
+        moved |= gap;
+      }
+    } while (laneMaskAny(moved));
+    
+    // Count remaining pieces
+    pieceLanes height = {0};
+    for (int y = 0; y < LOCKSTEP_HEIGHT; ++y) {
+      height -= (pieceLanes) (lockstep->cells[y][x] != PIECE_EMPTY);
+    }
+    lockstep->heights[x] = height;
+  }
+}
+
+/**
+ * Copy the board of a lane to a new playground and clear the lane.
+ * @param lockstep Lockstep boards
+ * @param lane Lane index
+ * @return Playground holding the board of the lane
+ */
+struct Playground* lockstepSpill(struct Lockstep* lockstep, unsigned long lane) {
+  struct Playground* playground = createPlayground();
+  for (int x = 0; x < LOCKSTEP_WIDTH; ++x) {
+    if (lockstep->heights[x][lane] > 0) {
+      struct Col* col = playgroundGetCol(playground, lockstep->originX[lane] + x);
+      for (int y = 0; y < lockstep->heights[x][lane]; ++y) {
+        if (col->count == col->size) {
+          resizeCol(col, col->count + 1);
+        }
+        colSetPiece(col, col->count, lockstep->cells[y][x][lane]);
+        ++col->count;
+        lockstep->cells[y][x][lane] = PIECE_EMPTY;
+      }
+      lockstep->heights[x][lane] = 0;
+    }
+  }
+  return playground;
+}
+
+/**
+ * Print the board of a lane in the format of playgroundPrint.
+ * @param lockstep Lockstep boards
+ * @param lane Lane index
+ */
+void lockstepPrint(struct Lockstep* lockstep, unsigned long lane) {
+  for (int x = 0; x < LOCKSTEP_WIDTH; ++x) {
+    for (int y = 0; y < lockstep->heights[x][lane]; ++y) {
+      printf("%d %ld %d\n", lockstep->cells[y][x][lane],
+        lockstep->originX[lane] + x, y);
+    }
+  }
+}
+
+/**
+ * Check whether any lane flag of a mask is set.
+ * @param mask Lane mask
+ * @return True, if any lane flag is set
+ */
+bool laneMaskAny(laneMask mask) {
+  uint64_t words[sizeof(laneMask) / sizeof(uint64_t)];
+  memcpy(words, &mask, sizeof(laneMask));
+  uint64_t any = 0;
+  for (unsigned long i = 0; i < sizeof(laneMask) / sizeof(uint64_t); ++i) {
+    any |= words[i];
+  }
+  return any != 0;
+}
+
+/**
+ * Create the shared memory segment the board gets published to and enable
+ * export mode. Fails if the name is taken, so the segment of another run is
+ * never truncated or removed.
+ * @param name Shared memory object name (e.g. "/crushing-four")
+ */
+void boardExportOpen(char* name) {
+  boardExport.fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (boardExport.fd == -1) {
+    if (errno == EEXIST) {
+      fprintf(stderr, "Shared memory segment %s already exists.\n", name);
+    } else {
+      fprintf(stderr, "Unable to open shared memory segment %s.\n", name);
+    }
+    exit(1);
+  }
+  boardExport.name = name;
+  boardExport.header = NULL;
+  boardExportResize(EXPORT_INITIAL_COLS, EXPORT_INITIAL_PIECES);
+  atomic_init(&boardExport.header->sequence, 0);
+  boardExport.header->movesCount = 0;
+  boardExport.header->colsCount = 0;
+  boardExport.piecesUsed = 0;
+}
+
+/**
+ * Unmap and remove the shared memory segment, if open. Readers having it
+ * mapped keep access to the final board.
+ */
+void boardExportClose(void) {
+  if (boardExport.header) {
+    munmap(boardExport.header, boardExport.header->size);
+    boardExport.header = NULL;
+  }
+  if (boardExport.name) {
+    close(boardExport.fd);
+    shm_unlink(boardExport.name);
+    boardExport.name = NULL;
+  }
+}
+
+/**
+ * Grow the shared memory segment and map it again. The col directory and
+ * piece area move, so their contents need to be written again.
+ * @param colsSize Number of col directory entries
+ * @param piecesSize Number of piece area bytes
+ */
+void boardExportResize(unsigned long colsSize, unsigned long piecesSize) {
+  unsigned long piecesOffset =
+    sizeof(struct ExportHeader) + colsSize * sizeof(struct ExportCol);
+  unsigned long size = piecesOffset + piecesSize;
+  if (boardExport.header) {
+    munmap(boardExport.header, boardExport.header->size);
+  }
+  
+  void* segment = MAP_FAILED;
+  if (ftruncate(boardExport.fd, size) == 0) {
+    segment = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+      boardExport.fd, 0);
+  }
+  if (segment == MAP_FAILED) {
+    boardExport.header = NULL;
+    handleOutOfMemory("map the board export");
+  }
+  
+  boardExport.header = (struct ExportHeader*) segment;
+  boardExport.cols = (struct ExportCol*)
+    ((char*) segment + sizeof(struct ExportHeader));
+  boardExport.pieces = (piece*) ((char*) segment + piecesOffset);
+  boardExport.piecesSize = piecesSize;
+  boardExport.header->size = size;
+  boardExport.header->colsSize = colsSize;
+  boardExport.header->piecesOffset = piecesOffset;
+}
+
+/**
+ * Start updating the exported board (odd sequence number).
+ */
+void boardExportBegin(void) {
+  atomic_ulong* sequence = &boardExport.header->sequence;
+  atomic_store_explicit(sequence,
+    atomic_load_explicit(sequence, memory_order_relaxed) + 1,
+    memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * Finish updating the exported board (even sequence number).
+ */
+void boardExportEnd(void) {
+  atomic_ulong* sequence = &boardExport.header->sequence;
+  atomic_store_explicit(sequence,
+    atomic_load_explicit(sequence, memory_order_relaxed) + 1,
+    memory_order_release);
+}
+
+/**
+ * Publish the cols changed by the last move. The changed cols form a run of
+ * adjacent cols including the col the piece was placed on, as every line
+ * crosses a col changed before. Falls back to publishing the whole board if
+ * the segment runs out of space.
+ * @param playground Playground instance
+ * @param col Col the piece was placed on
+ * @param x Col x-position
+ */
+void playgroundExportMove(struct Playground* playground, struct Col* col, long x) {
+  boardExportBegin();
+  
+  // Find the lowest changed col
+  while (col->prev && !colIsPadding(col->prev) &&
+      col->prev->changeY != col->prev->size) {
+    col = col->prev;
+    --x;
+  }
+  
+  // Publish changed cols in x-order
+  do {
+    if (!boardExportCol(x, col)) {
+      playgroundExportBoard(playground);
+      break;
+    }
+    col = col->next;
+    ++x;
+  } while (col && !colIsPadding(col) && col->changeY != col->size);
+  
+  ++boardExport.header->movesCount;
+  boardExportEnd();
+}
+
+/**
+ * Publish a single col, inserting, moving or removing its directory entry as
+ * needed.
+ * @param x Col x-position
+ * @param col Col to be published
+ * @return False, if the col directory or piece area is full
+ */
+bool boardExportCol(long x, struct Col* col) {
+  struct ExportHeader* header = boardExport.header;
+  struct ExportCol* cols = boardExport.cols;
+  
+  // Find the first entry at or above x
+  unsigned long lo = 0;
+  unsigned long hi = header->colsCount;
+  while (lo < hi) {
+    unsigned long mid = (lo + hi) / 2;
+    if (cols[mid].x < x) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  bool found = lo < header->colsCount && cols[lo].x == x;
+  
+  if (col->count == 0) {
+    // Remove the entry of an emptied col
+    if (found) {
+      memmove(&cols[lo], &cols[lo + 1],
+        (header->colsCount - lo - 1) * sizeof(struct ExportCol));
+      --header->colsCount;
+    }
+    return true;
+  }
+  
+  if (!found) {
+    // Insert an entry
+    if (header->colsCount == header->colsSize) {
+      return false;
+    }
+    memmove(&cols[lo + 1], &cols[lo],
+      (header->colsCount - lo) * sizeof(struct ExportCol));
+    ++header->colsCount;
+    cols[lo].x = x;
+    cols[lo].count = 0;
+    cols[lo].size = 0;
+  }
+  
+  if (cols[lo].size < col->count) {
+    // Move the col pieces to the end of the piece area
+    unsigned long size = col->count + col->count / 2 + EXPORT_COL_SLACK;
+    if (boardExport.piecesUsed + size > boardExport.piecesSize) {
+      return false;
+    }
+    cols[lo].offset = boardExport.piecesUsed;
+    cols[lo].size = size;
+    boardExport.piecesUsed += size;
+  }
+  
+  colExportPieces(col, boardExport.pieces + cols[lo].offset);
+  cols[lo].count = col->count;
+  return true;
+}
+
+/**
+ * Publish the whole board, compacting the piece area and growing the segment
+ * if necessary. Must be called between boardExportBegin and boardExportEnd.
+ * @param playground Playground instance
+ */
+void playgroundExportBoard(struct Playground* playground) {
+  unsigned long colsCount = 0;
+  unsigned long piecesCount = 0;
+  struct Col* col;
+  
+  for (col = playground->startCol; col; col = col->next) {
+    if (!colIsPadding(col) && col->count > 0) {
+      ++colsCount;
+      piecesCount += col->count + col->count / 2 + EXPORT_COL_SLACK;
+    }
+  }
+  
+  if (colsCount > boardExport.header->colsSize ||
+      piecesCount > boardExport.piecesSize) {
+    unsigned long colsSize = boardExport.header->colsSize;
+    unsigned long piecesSize = boardExport.piecesSize;
+    while (colsSize < 2 * colsCount) {
+      colsSize *= 2;
+    }
+    while (piecesSize < 2 * piecesCount) {
+      piecesSize *= 2;
+    }
+    boardExportResize(colsSize, piecesSize);
+  }
+  
+  boardExport.header->colsCount = 0;
+  boardExport.piecesUsed = 0;
+  long x = playground->startColX;
+  for (col = playground->startCol; col; col = col->next) {
+    if (colIsPadding(col)) {
+      x += col->size;
+    } else {
+      if (col->count > 0) {
+        struct ExportCol* entry =
+          &boardExport.cols[boardExport.header->colsCount++];
+        entry->x = x;
+        entry->offset = boardExport.piecesUsed;
+        entry->count = col->count;
+        entry->size = col->count + col->count / 2 + EXPORT_COL_SLACK;
+        colExportPieces(col, boardExport.pieces + entry->offset);
+        boardExport.piecesUsed += entry->size;
+      }
+      ++x;
+    }
+  }
+}
+
+/**
+ * Copy the pieces of a col to a flat array.
+ * @param col Col to be copied
+ * @param pieces Array of at least count pieces
+ */
+void colExportPieces(struct Col* col, piece* pieces) {
+  if (colIsInline(col)) {
+    memcpy(pieces, col->pieces, col->count * sizeof(piece));
+    return;
+  }
+  if (!col->chunkIndex->resident) {
+    colPageIn(col);
+  }
+  for (unsigned long i = 0; i * COL_CHUNK_SIZE < col->count; ++i) {
+    unsigned long count = col->count - i * COL_CHUNK_SIZE;
+    memcpy(pieces + i * COL_CHUNK_SIZE, col->chunkIndex->chunks[i].chunk->pieces,
+      (count < COL_CHUNK_SIZE ? count : COL_CHUNK_SIZE) * sizeof(piece));
+  }
+}
+
+/**
+ * Run microbenchmarks of the core routines and print their time per
+ * operation in nanoseconds (mean, standard deviation and minimum of the
+ * repetitions). Line detection is measured with the strategy selected by the
+ * command line options.
+ */
+void runBenchmarks(void) {
+  printf("%-40s %10s %10s %10s\n", "Benchmark", "ns/op", "stddev", "min");
+  benchmarkRun("getCol (distance 1)", benchmarkGetCol, 1, 1000000);
+  benchmarkRun("getCol (distance 16)", benchmarkGetCol, 16, 100000);
+  benchmarkRun("getCol (distance 256)", benchmarkGetCol, 256, 10000);
+  benchmarkRun("getCol (distance 256, padded)", benchmarkGetSparseCol, 256,
+    100000);
+  benchmarkRun("removeLines (256x8, 4 rows changed)", benchmarkRemoveLines, 0,
+    1000);
+  benchmarkRun("removeLines (8x1024, 64 rows changed)", benchmarkRemoveLines,
+    1, 1000);
+  benchmarkRun("removeLines (256x8, 1 piece changed)", benchmarkRemoveLines, 2,
+    100000);
+  benchmarkRun("causeGravity (1024, 1/64 removed)", benchmarkCauseGravity, 64,
+    1000);
+  benchmarkRun("causeGravity (1024, 1/8 removed)", benchmarkCauseGravity, 8,
+    1000);
+  benchmarkRun("causeGravity (1024, 1/2 removed)", benchmarkCauseGravity, 2,
+    1000);
+  benchmarkRun("resizeCol (inline to chunks)", benchmarkResizeCol,
+    COL_INLINE_SIZE, 100000);
+  benchmarkRun("resizeCol (add chunk at 4096)", benchmarkResizeCol, 4096,
+    100000);
+  benchmarkRun("print (64x64)", benchmarkPrint, 64, 100);
+  benchmarkRun("print (1024x64)", benchmarkPrint, 1024, 10);
+}
+
+/**
+ * Run a microbenchmark repeatedly after warming up and print its statistics.
+ * @param name Benchmark name
+ * @param benchmark Benchmark function returning the nanoseconds taken by the
+ * given number of operations
+ * @param param Parameter passed to the benchmark function
+ * @param ops Number of operations per repetition
+ */
+void benchmarkRun(char* name, unsigned long (*benchmark)(long, unsigned long), long param, unsigned long ops) {
+  double samples[BENCHMARK_REPETITIONS];
+  double mean = 0;
+  double variance = 0;
+  double min = 0;
+  int i;
+  
+  for (i = 0; i < BENCHMARK_WARMUP; ++i) {
+    benchmark(param, ops);
+  }
+  for (i = 0; i < BENCHMARK_REPETITIONS; ++i) {
+    samples[i] = (double) benchmark(param, ops) / ops;
+    mean += samples[i] / BENCHMARK_REPETITIONS;
+    min = i == 0 || samples[i] < min ? samples[i] : min;
+  }
+  for (i = 0; i < BENCHMARK_REPETITIONS; ++i) {
+    variance += (samples[i] - mean) * (samples[i] - mean) /
+      (BENCHMARK_REPETITIONS - 1);
+  }
+  
+  // Standard deviation using Newton's method to not depend on libm
+  double stddev = variance;
+  for (i = 0; i < 64 && stddev > 0; ++i) {
+    stddev = (stddev + variance / stddev) / 2;
+  }
+  printf("%-40s %10.1f %10.1f %10.1f\n", name, mean, stddev, min);
+  fflush(stdout);
+}
+
+/**
+ * Read the monotonic clock.
+ * @return Nanoseconds
+ */
+unsigned long benchmarkClock(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1000000000UL + time.tv_nsec;
+}
+
+/**
+ * Create a playground of cols of equal height without lines. Neighbouring
+ * pieces in all directions differ in color.
+ * @param width Number of cols
+ * @param step Distance between cols, padding cols fill the gaps
+ * @param height Number of pieces per col
+ * @return Playground
+ */
+struct Playground* createBenchmarkPlayground(long width, long step, unsigned long height) {
+  struct Playground* playground = createPlayground();
+  for (long i = 0; i < width; ++i) {
+    struct Col* col = playgroundGetCol(playground, i * step);
+    resizeCol(col, height);
+    for (unsigned long y = 0; y < height; ++y) {
+      colSetPiece(col, y, (i * 3 + y * 7) % 250);
+    }
+    col->count = height;
+  }
+  return playground;
+}
+
+/**
+ * Measure playgroundGetCol moving the cursor by the given distance.
+ * @param distance Number of cols between consecutive lookups
+ * @param ops Number of lookups
+ * @return Nanoseconds taken
+ */
+unsigned long benchmarkGetCol(long distance, unsigned long ops) {
+  struct Playground* playground = createBenchmarkPlayground(4096, 1, 1);
+  unsigned long duration = benchmarkSeek(playground, 4096, distance, ops);
+  freePlayground(playground);
+  return duration;
+}
+
+/**
+ * Measure playgroundGetCol moving the cursor by the given distance over cols
+ * separated by padding cols.
+ * @param distance Distance between consecutive lookups
+ * @param ops Number of lookups
+ * @return Nanoseconds taken
+ */
+unsigned long benchmarkGetSparseCol(long distance, unsigned long ops) {
+  struct Playground* playground = createBenchmarkPlayground(4096, 16, 1);
+  unsigned long duration = benchmarkSeek(playground, 4096 * 16, distance, ops);
+  freePlayground(playground);
+  return duration;
+}
+
+/**
+ * Look up existing cols moving the cursor by the given distance.
+ * @param playground Playground having cols at all looked up positions
+ * @param width Width of the looked up range
+ * @param distance Distance between consecutive lookups
+ * @param ops Number of lookups
+ * @return Nanoseconds taken
+ */
+unsigned long benchmarkSeek(struct Playground* playground, long width, long distance, unsigned long ops) {
+  long x = 0;
+  unsigned long start = benchmarkClock();
+  for (unsigned long i = 0; i < ops; ++i) {
+    x = (x + distance) % width;
+    benchmarkSink ^= (uintptr_t) playgroundGetCol(playground, x);
+  }
+  return benchmarkClock() - start;
+}
+
+/**
+ * Measure playgroundRemoveLines on a board shape without lines. As nothing
+ * gets marked, the changes are kept between calls.
+ * @param shape 0: 256 cols of 8 pieces with the upper 4 rows changed, 1: 8
+ * cols of 1024 pieces with the upper 64 rows changed, 2: 256 cols of 8 pieces
+ * with a single changed piece
+ * @param ops Number of calls
+ * @return Nanoseconds taken
+ */
+unsigned long benchmarkRemoveLines(long shape, unsigned long ops) {
+  long width = shape == 1 ? 8 : 256;
+  unsigned long height = shape == 1 ? 1024 : 8;
+  unsigned long changedRows = shape == 1 ? 64 : 4;
+  struct Playground* playground =
+    createBenchmarkPlayground(width, 1, height);
+  
+  if (shape == 2) {
+    playgroundTrackChange(playground, playgroundGetCol(playground, width / 2),
+      height - 1);
+  } else {
+    for (long x = 0; x < width; ++x) {
+      playgroundTrackChange(playground, playgroundGetCol(playground, x),
+        height - changedRows);
+    }
+  }
+  if (playground->bitboard) {
+    playground->bitboard->focusX = width / 2;
+  }
+  
+  unsigned long start = benchmarkClock();
+  for (unsigned long i = 0; i < ops; ++i) {
+    playgroundRemoveLines(playground);
+  }
+  unsigned long duration = benchmarkClock() - start;
+  benchmarkSink ^= playground->pieceRemovalsCount;
+  freePlayground(playground);
+  return duration;
+}
+
+/**
+ * Measure playgroundCauseGravity on a col of 1024 pieces with every
+ * interval-th piece of the upper half marked to be removed.
+ * @param interval Distance between removed pieces
+ * @param ops Number of calls
+ * @return Nanoseconds taken
+ */
+unsigned long benchmarkCauseGravity(long interval, unsigned long ops) {
+  unsigned long height = 1024;
+  struct Playground* playground = createBenchmarkPlayground(1, 1, height);
+  struct Col* col = playground->originCol;
+  unsigned long duration = 0;
+  
+  for (unsigned long i = 0; i < ops; ++i) {
+    for (unsigned long y = height / 2; y < height; y += interval) {
+      playgroundRemovePiece(playground, col, y);
+    }
+    
+    unsigned long start = benchmarkClock();
+    playgroundCauseGravity(playground);
+    duration += benchmarkClock() - start;
+    
+    // Restore col
+    for (unsigned long y = 0; y < height; ++y) {
+      colSetPiece(col, y, (y * 7) % 250);
+    }
+    col->count = height;
+    col->changeY = col->size;
+    playground->changedColsCount = 0;
+    playground->pieceRemovalsCount = 0;
+  }
+  freePlayground(playground);
+  return duration;
+}
+
+/**
+ * Measure resizeCol growing a full col by one piece.
+ * @param count Number of pieces in the col
+ * @param ops Number of calls
+ * @return Nanoseconds taken
+ */
+unsigned long benchmarkResizeCol(long count, unsigned long ops) {
+  struct Playground* playground = createBenchmarkPlayground(1, 1, count);
+  struct Col* col = playground->originCol;
+  unsigned long duration = 0;
+  
+  for (unsigned long i = 0; i < ops; ++i) {
+    unsigned long start = benchmarkClock();
+    resizeCol(col, count + 1);
+    duration += benchmarkClock() - start;
+    resizeCol(col, count);
+  }
+  freePlayground(playground);
+  return duration;
+}
+
+/**
+ * Measure playgroundPrint writing a board of 64 rows to /dev/null.
+ * @param width Number of cols
+ * @param ops Number of calls
+ * @return Nanoseconds taken
+ */
+unsigned long benchmarkPrint(long width, unsigned long ops) {
+  struct Playground* playground = createBenchmarkPlayground(width, 1, 64);
+  FILE* null = fopen("/dev/null", "w");
+  if (!null) {
+    freePlayground(playground);
+    return 0;
+  }
+  
+  // Redirect stdout
+  fflush(stdout);
+  int output = dup(STDOUT_FILENO);
+  dup2(fileno(null), STDOUT_FILENO);
+  
+  unsigned long start = benchmarkClock();
+  for (unsigned long i = 0; i < ops; ++i) {
+    playgroundPrint(playground);
+    fflush(stdout);
+  }
+  unsigned long duration = benchmarkClock() - start;
+  
+  // Restore stdout
+  dup2(output, STDOUT_FILENO);
+  close(output);
+  fclose(null);
+  freePlayground(playground);
+  return duration;
+}
+
+/**
+ * Read the moves of a batch game from its input file. Reading stops at the
+ * first unexpected line, which gets reported.
+ * @param game Game with path set
+ */
+void readGame(struct Game* game) {
+  unsigned long movesSize = INITIAL_GAME_SIZE;
+  game->movesCount = 0;
+  game->validInput = true;
+  game->moves = (struct Move*) malloc(movesSize * sizeof(struct Move));
+  if (!game->moves) {
+    handleOutOfMemory("read a game");
+  }
+  
+  FILE* file = fopen(game->path, "r");
+  if (!file) {
+    fprintf(stderr, "Unable to read %s.\n", game->path);
+    game->validInput = false;
+    return;
+  }
+  
+  char *line = NULL;
+  size_t lineSize = 32;
+  long lineLength;
+  while ((lineLength = getline(&line, &lineSize, file)) > 0) {
+    // Dynamically increase move array size, if necessary
+    if (game->movesCount == movesSize) {
+      movesSize *= 2;
+      struct Move* moves = (struct Move*)
+        realloc(game->moves, movesSize * sizeof(struct Move));
+      if (!moves) {
+        handleOutOfMemory("read a game");
+      }
+      game->moves = moves;
+    }
+    
+    struct Move* move = &game->moves[game->movesCount];
+    if (!parseMove(line, lineLength, &move->p, &move->x)) {
+      fprintf(stderr, "Unexpected input in %s. "
+        "Expected line format: ^[0-9]+ +-?[0-9]+$\n", game->path);
+      game->validInput = false;
+      break;
+    }
+    ++game->movesCount;
+  }
+  
+  free(line);
+  fclose(file);
+}
+
+/**
+ * Compare batch games by their move sequences (trie order).
+ * @param a Pointer to pointer to first game
+ * @param b Pointer to pointer to second game
+ * @return Comparison result
+ */
+int compareGames(const void* a, const void* b) {
+  const struct Game* gameA = *(const struct Game* const*) a;
+  const struct Game* gameB = *(const struct Game* const*) b;
+  for (unsigned long i = 0; i < gameA->movesCount && i < gameB->movesCount; ++i) {
+    const struct Move* moveA = &gameA->moves[i];
+    const struct Move* moveB = &gameB->moves[i];
+    if (moveA->x != moveB->x) {
+      return (moveA->x > moveB->x) - (moveA->x < moveB->x);
+    }
+    if (moveA->p != moveB->p) {
+      return (moveA->p > moveB->p) - (moveA->p < moveB->p);
+    }
+  }
+  return (gameA->movesCount > gameB->movesCount) -
+    (gameA->movesCount < gameB->movesCount);
+}
+
+/**
+ * Create a move trie node.
+ * @param move Move leading to the node, NULL for the root
+ * @return Pointer to new node
+ */
+struct MoveNode* createMoveNode(struct Move* move) {
+  struct MoveNode* node = (struct MoveNode*) malloc(sizeof(struct MoveNode));
+  if (!node) {
+    handleOutOfMemory("create a move trie node");
+  }
+  if (move) {
+    node->move = *move;
+  }
+  node->firstChild = NULL;
+  node->nextSibling = NULL;
+  node->childCount = 0;
+  node->passCount = 0;
+  node->endCount = 0;
+  node->visitCount = 0;
+  node->snapshot = NULL;
+  node->snapshotSize = 0;
+  node->newer = NULL;
+  node->older = NULL;
+  return node;
+}
+
+/**
+ * Find the child node reached by the given move. Lazily creates it.
+ * @param node Parent node
+ * @param move Move
+ * @return Pointer to child node
+ */
+struct MoveNode* moveNodeGetChild(struct MoveNode* node, struct Move* move) {
+  struct MoveNode* child = node->firstChild;
+  while (child && (child->move.x != move->x || child->move.p != move->p)) {
+    child = child->nextSibling;
+  }
+  if (!child) {
+    child = createMoveNode(move);
+    child->nextSibling = node->firstChild;
+    node->firstChild = child;
+    ++node->childCount;
+  }
+  return child;
+}
+
+/**
+ * Free a move trie node, its snapshot and its descendants.
+ * @param cache Snapshot cache
+ * @param node Node to free
+ */
+void freeMoveNode(struct SnapshotCache* cache, struct MoveNode* node) {
+  // Free siblings and descendants iteratively, as the trie is as deep as the
+  // longest game
+  struct MoveNode* next;
+  struct MoveNode* last;
+  while (node) {
+    next = node->nextSibling;
+    if (node->firstChild) {
+      // Splice the children into the list of nodes to be freed
+      for (last = node->firstChild; last->nextSibling;
+          last = last->nextSibling);
+      last->nextSibling = next;
+      next = node->firstChild;
+    }
+    if (node->snapshot) {
+      snapshotCacheRemove(cache, node);
+    }
+    free(node);
+    node = next;
+  }
+}
+
+/**
+ * Add the snapshot of a node to the cache and evict the least recently used
+ * snapshots exceeding the cache budget.
+ * @param cache Snapshot cache
+ * @param node Node holding a snapshot not yet being cached
+ */
+void snapshotCacheInsert(struct SnapshotCache* cache, struct MoveNode* node) {
+  node->newer = NULL;
+  node->older = cache->newest;
+  if (cache->newest) {
+    cache->newest->newer = node;
+  } else {
+    cache->oldest = node;
+  }
+  cache->newest = node;
+  cache->size += node->snapshotSize;
+  
+  while (cache->size > cache->budget && cache->oldest) {
+    snapshotCacheRemove(cache, cache->oldest);
+  }
+}
+
+/**
+ * Mark the snapshot of a node as the most recently used one.
+ * @param cache Snapshot cache
+ * @param node Node holding a cached snapshot
+ */
+void snapshotCacheTouch(struct SnapshotCache* cache, struct MoveNode* node) {
+  if (cache->newest != node) {
+    struct Playground* snapshot = node->snapshot;
+    snapshotCacheRemove(cache, node);
+    node->snapshot = snapshot;
+    snapshotCacheInsert(cache, node);
+  }
+}
+
+/**
+ * Remove the snapshot of a node from the cache and free it.
+ * @param cache Snapshot cache
+ * @param node Node holding a cached snapshot
+ */
+void snapshotCacheRemove(struct SnapshotCache* cache, struct MoveNode* node) {
+  if (node->newer) {
+    node->newer->older = node->older;
+  } else {
+    cache->newest = node->older;
+  }
+  if (node->older) {
+    node->older->newer = node->newer;
+  } else {
+    cache->oldest = node->newer;
+  }
+  cache->size -= node->snapshotSize;
+  freePlayground(node->snapshot);
+  node->snapshot = NULL;
+}
+
+/**
+ * Handle the event of running out of memory.
+ * @param description Task at which the program ran out of memory
+ */
+void handleOutOfMemory(char description[]) {
+  fprintf(stderr, "Not enough memory left to %s.\n", description);
+  freePlayground(playground);
+  playground = NULL;
+  chunkStoreClose();
+  boardExportClose();
+  exit(1);
+}
+
+/**
+ * Create empty playground (containing a single origin node).
+ * Assumptions:
+ * - Origin, start and end cols must not be of type padding
+ * - Two adjancent padding cols are not allowed
+ * @return Pointer to playground
+ */
+struct Playground* createPlayground(void) {
+  struct Playground* playground = (struct Playground*) malloc(
+    sizeof(struct Playground));
+  if (!playground) {
+    handleOutOfMemory("create a playground");
+  }
+
+  struct Col* col = createCol();
+  playground->originCol = col;
+  playground->startCol = col;
+  playground->startColX = 0;
+  playground->endCol = col;
+  playground->endColX = 0;
+  playground->currentCol = col;
+  playground->currentX = 0;
+  
+  playground->changedColsSize = INITIAL_CHANGES_SIZE;
+  playground->changedColsCount = 0;
+  playground->changedCols = (struct Col**)
+    malloc(playground->changedColsSize * sizeof(struct Col*));
+  if (!playground->changedCols) {
+    handleOutOfMemory("create a playground");
+  }
+  
+  playground->guardColsCount = 0;
+  playground->guardTouched = false;
+
+  playground->pieceRemovalsCount = 0;
+  
+  playground->sweepHeads = NULL;
+  playground->sweepHeadsCount = 0;
+  playground->sweepHeadsSize = 0;
+  playground->sweepMarks = NULL;
+  playground->sweepMarksCount = 0;
+  playground->sweepMarksSize = 0;
+  
+  playground->boardExport = NULL;
+  
+  playground->bitboard = NULL;
+  if (bitboardDetection) {
+    playground->bitboard = (struct Bitboard*) malloc(sizeof(struct Bitboard));
+    if (!playground->bitboard) {
+      handleOutOfMemory("create a playground");
+    }
+    playground->bitboard->valid = false;
+    playground->bitboard->focusX = 0;
+  }
+  
+  return playground;
+}
+
+/**
+ * Create a deep copy of a playground.
+ * @param source Playground to be copied
+ * @param size Pointer the number of bytes allocated by the copy gets written
+ * to, may be NULL
+ * @return Pointer to the copy
+ */
+struct Playground* clonePlayground(struct Playground* source, unsigned long* size) {
+  struct Playground* playground = createPlayground();
+  struct Col* sourceCol = source->startCol;
+  struct Col* col;
+  long x = source->startColX;
+  
+  // Copy non-empty cols in order, lazily creating padding cols
+  while (sourceCol) {
+    if (!colIsPadding(sourceCol)) {
+      if (sourceCol->count > 0) {
+        col = playgroundGetCol(playground, x);
+        colCopyPieces(col, sourceCol);
+      }
+      ++x;
+    } else {
+      x += sourceCol->size;
+    }
+    sourceCol = sourceCol->next;
+  }
+  
+  if (size) {
+    // Estimate allocated bytes
+    *size = sizeof(struct Playground) +
+      playground->changedColsSize * sizeof(struct Col*) +
+      (playground->bitboard ? sizeof(struct Bitboard) : 0);
+    for (col = playground->startCol; col; col = col->next) {
+      *size += sizeof(struct Col);
+      if (!colIsPadding(col) && !colIsInline(col)) {
+        *size += sizeof(struct ChunkIndex) +
+          col->chunkIndex->size * sizeof(union ChunkRef) +
+          col->size / COL_CHUNK_SIZE * sizeof(struct Chunk);
+      }
+    }
+  }
+  return playground;
+}
+
+/**
+ * Frees a playground instance with all of its cols.
+ * @param playground Playground instance to free
+ */
+void freePlayground(struct Playground* playground) {
+  if (playground) {
+    // Free cols in playground
+    struct Col* col = playground->startCol;
+    struct Col* next;
+    while (col) {
+      next = col->next;
+      freeCol(col);
+      col = next;
+    }
+    
+    // Free change array and bitboard window
+    free(playground->changedCols);
+    free(playground->bitboard);
+    free(playground->sweepHeads);
+    free(playground->sweepMarks);
+
+    // Free playground itself
+    free(playground);
+  }
+}
+
+/**
+ * Create a col node with inline storage.
+ * @return Pointer to new col node
+ */
+struct Col* createCol(void) {
+  struct Col* col = (struct Col*) malloc(sizeof(struct Col));
+  if (!col) {
+    handleOutOfMemory("create a column");
+  }
+  col->size = COL_INLINE_SIZE;
+  col->count = 0;
+  col->changeY = COL_INLINE_SIZE;
+  col->removals = 0;
+  col->next = NULL;
+  col->prev = NULL;
+  return col;
+}
+
+/**
+ * Frees a col node including its chunks.
+ * @param col Pointer to col node to free
+ */
+void freeCol(struct Col* col) {
+  if (!colIsPadding(col) && !colIsInline(col)) {
+    struct ChunkIndex* chunkIndex = col->chunkIndex;
+    unsigned long chunkCount = col->size / COL_CHUNK_SIZE;
+    for (unsigned long i = 0; i < chunkCount; ++i) {
+      if (chunkIndex->resident) {
+        free(chunkIndex->chunks[i].chunk);
+      } else {
+        chunkStoreFreeSlot(chunkIndex->chunks[i].slot);
+      }
+    }
+    if (chunkStore.file) {
+      if (chunkIndex->resident) {
+        chunkStoreUnlink(chunkIndex);
+        chunkStore.residentSize -= chunkCount * sizeof(struct Chunk);
+      }
+      chunkStore.residentSize -= sizeof(struct ChunkIndex) +
+        chunkIndex->size * sizeof(union ChunkRef);
+    }
+    free(chunkIndex);
+  }
+  free(col);
+}
+
+/**
+ * Resize a col node to fit at least the given number of pieces. Cols fitting
+ * into the inline storage keep their pieces inside the col node, larger cols
+ * allocate or free chunks at their top. Existing chunks and the col node
+ * itself never move.
+ * @param col Pointer to col to be resized
+ * @param size Number of pieces the col should fit
+ */
+void resizeCol(struct Col* col, unsigned long size) {
+  struct ChunkIndex* chunkIndex;
+  struct Chunk* chunk;
+  unsigned long newSize;
+  
+  if (size > COL_MAX_SIZE) {
+    handleOutOfMemory("resize a column");
+  }
+  
+  if (!colIsInline(col) && !col->chunkIndex->resident) {
+    colPageIn(col);
+  }
+  
+  if (size <= COL_INLINE_SIZE) {
+    if (!colIsInline(col)) {
+      // Move pieces back into the col node and free the chunks
+      chunkIndex = col->chunkIndex;
+      chunk = chunkIndex->chunks[0].chunk;
+      memcpy(col->pieces, chunk->pieces, sizeof(piece) * COL_INLINE_SIZE);
+      col->removals = (uint32_t) chunk->removals;
+      for (unsigned long i = 0; i < col->size / COL_CHUNK_SIZE; ++i) {
+        free(chunkIndex->chunks[i].chunk);
+      }
+      if (chunkStore.file) {
+        chunkStoreUnlink(chunkIndex);
+        chunkStore.residentSize -= col->size / COL_CHUNK_SIZE * sizeof(struct Chunk) +
+          sizeof(struct ChunkIndex) + chunkIndex->size * sizeof(union ChunkRef);
+      }
+      free(chunkIndex);
+      newSize = COL_INLINE_SIZE;
+      if (col->changeY == col->size) {
+        col->changeY = newSize;
+      }
+      col->size = newSize;
+    }
+    return;
+  }
+  
+  if (colIsInline(col)) {
+    // Move inline pieces into a first chunk
+    chunkIndex = (struct ChunkIndex*) malloc(
+      sizeof(struct ChunkIndex) + INITIAL_CHUNKS_SIZE * sizeof(union ChunkRef));
+    chunk = (struct Chunk*) malloc(sizeof(struct Chunk));
+    if (!chunkIndex || !chunk) {
+      handleOutOfMemory("resize a column");
+    }
+    memcpy(chunk->pieces, col->pieces, sizeof(piece) * COL_INLINE_SIZE);
+    chunk->removals = col->removals;
+    col->removals = 0;
+    chunkIndex->size = INITIAL_CHUNKS_SIZE;
+    chunkIndex->resident = true;
+    chunkIndex->col = col;
+    chunkIndex->chunks[0].chunk = chunk;
+    col->chunkIndex = chunkIndex;
+    if (chunkStore.file) {
+      chunkIndex->lastUse = chunkStore.clock;
+      chunkStoreLink(chunkIndex);
+      chunkStore.residentSize += sizeof(struct Chunk) +
+        sizeof(struct ChunkIndex) + INITIAL_CHUNKS_SIZE * sizeof(union ChunkRef);
+    }
+    newSize = COL_CHUNK_SIZE;
+    if (col->changeY == col->size) {
+      col->changeY = newSize;
+    }
+    col->size = newSize;
+  }
+  
+  unsigned long chunkCount = col->size / COL_CHUNK_SIZE;
+  unsigned long newChunkCount = (size + COL_CHUNK_SIZE - 1) / COL_CHUNK_SIZE;
+  
+  // Dynamically increase chunk index size, if necessary
+  if (newChunkCount > col->chunkIndex->size) {
+    unsigned long chunksSize = col->chunkIndex->size;
+    while (chunksSize < newChunkCount) {
+      chunksSize *= 2;
+    }
+    if (chunkStore.file) {
+      chunkStoreUnlink(col->chunkIndex);
+    }
+    chunkIndex = (struct ChunkIndex*) realloc(col->chunkIndex,
+      sizeof(struct ChunkIndex) + chunksSize * sizeof(union ChunkRef));
+    if (!chunkIndex) {
+      handleOutOfMemory("resize a column");
+    }
+    if (chunkStore.file) {
+      chunkStoreLink(chunkIndex);
+      chunkStore.residentSize +=
+        (chunksSize - chunkIndex->size) * sizeof(union ChunkRef);
+    }
+    chunkIndex->size = chunksSize;
+    col->chunkIndex = chunkIndex;
+  }
+  
+  // Allocate new chunks or free chunks at the top
+  while (chunkCount < newChunkCount) {
+    chunk = (struct Chunk*) malloc(sizeof(struct Chunk));
+    if (!chunk) {
+      handleOutOfMemory("resize a column");
+    }
+    chunk->removals = 0;
+    col->chunkIndex->chunks[chunkCount++].chunk = chunk;
+    if (chunkStore.file) {
+      chunkStore.residentSize += sizeof(struct Chunk);
+    }
+    // Keep size in sync to let freeCol release allocated chunks
+    newSize = chunkCount * COL_CHUNK_SIZE;
+    if (col->changeY == col->size) {
+      col->changeY = newSize;
+    }
+    col->size = newSize;
+  }
+  while (chunkCount > newChunkCount) {
+    free(col->chunkIndex->chunks[--chunkCount].chunk);
+    if (chunkStore.file) {
+      chunkStore.residentSize -= sizeof(struct Chunk);
+    }
+    newSize = chunkCount * COL_CHUNK_SIZE;
+    if (col->changeY == col->size) {
+      col->changeY = newSize;
+    }
+    col->size = newSize;
+  }
+}
+
+/**
+ * Replace the pieces of a col by the pieces of another col.
+ * @param col Col instance to copy pieces to
+ * @param source Col instance to copy pieces from
+ */
+void colCopyPieces(struct Col* col, struct Col* source) {
+  resizeCol(col, source->count);
+  if (colIsInline(col)) {
+    for (unsigned long y = 0; y < source->count; ++y) {
+      col->pieces[y] = colGetPiece(source, y);
+    }
+  } else {
+    if (!source->chunkIndex->resident) {
+      colPageIn(source);
+    }
+    for (unsigned long i = 0; i * COL_CHUNK_SIZE < source->count; ++i) {
+      memcpy(col->chunkIndex->chunks[i].chunk->pieces,
+        source->chunkIndex->chunks[i].chunk->pieces,
+        sizeof(piece) * COL_CHUNK_SIZE);
+    }
+  }
+  col->count = source->count;
+}
+
+/**
+ * Open the backing file evicted col chunks get written to and enable
+ * out-of-core mode.
+ * @param path Backing file path, NULL to use an anonymous temporary file
+ * @param budget Maximum number of bytes of chunks and chunk indexes kept in
+ * memory
+ */
+void chunkStoreOpen(char* path, unsigned long budget) {
+  chunkStore.file = path ? fopen(path, "w+b") : tmpfile();
+  if (!chunkStore.file) {
+    fprintf(stderr, "Unable to open backing file.\n");
+    exit(1);
+  }
+  chunkStore.fd = fileno(chunkStore.file);
+  chunkStore.budget = budget;
+  chunkStore.residentSize = 0;
+  chunkStore.slotsCount = 0;
+  chunkStore.freeSlotsCount = 0;
+  chunkStore.freeSlotsSize = 0;
+  chunkStore.freeSlots = NULL;
+  chunkStore.newest = NULL;
+  chunkStore.oldest = NULL;
+  chunkStore.clock = 0;
+}
+
+/**
+ * Close the backing file and disable out-of-core mode.
+ */
+void chunkStoreClose(void) {
+  if (chunkStore.file) {
+    fclose(chunkStore.file);
+    free(chunkStore.freeSlots);
+    chunkStore.file = NULL;
+    chunkStore.freeSlots = NULL;
+  }
+}
+
+/**
+ * Mark the given col as the most recently used resident col.
+ * @param col Resident chunked col instance
+ */
+void chunkStoreTouch(struct Col* col) {
+  struct ChunkIndex* chunkIndex = col->chunkIndex;
+  chunkIndex->lastUse = chunkStore.clock;
+  if (chunkStore.newest != chunkIndex) {
+    chunkStoreUnlink(chunkIndex);
+    chunkStoreLink(chunkIndex);
+  }
+}
+
+/**
+ * Insert the given chunk index at the most recently used end of the resident
+ * list.
+ * @param chunkIndex Chunk index not being part of the list
+ */
+void chunkStoreLink(struct ChunkIndex* chunkIndex) {
+  chunkIndex->newer = NULL;
+  chunkIndex->older = chunkStore.newest;
+  if (chunkStore.newest) {
+    chunkStore.newest->newer = chunkIndex;
+  } else {
+    chunkStore.oldest = chunkIndex;
+  }
+  chunkStore.newest = chunkIndex;
+}
+
+/**
+ * Remove the given chunk index from the resident list.
+ * @param chunkIndex Chunk index being part of the list
+ */
+void chunkStoreUnlink(struct ChunkIndex* chunkIndex) {
+  if (chunkIndex->newer) {
+    chunkIndex->newer->older = chunkIndex->older;
+  } else {
+    chunkStore.newest = chunkIndex->older;
+  }
+  if (chunkIndex->older) {
+    chunkIndex->older->newer = chunkIndex->newer;
+  } else {
+    chunkStore.oldest = chunkIndex->newer;
+  }
+}
+
+/**
+ * Release a backing file slot for reuse.
+ * @param slot Slot index
+ */
+void chunkStoreFreeSlot(unsigned long slot) {
+  if (chunkStore.freeSlotsCount == chunkStore.freeSlotsSize) {
+    // Dynamically increase free slot array size
+    unsigned long freeSlotsSize =
+      chunkStore.freeSlotsSize ? chunkStore.freeSlotsSize * 2 : 64;
+    unsigned long* freeSlots = (unsigned long*) realloc(
+      chunkStore.freeSlots, freeSlotsSize * sizeof(unsigned long));
+    if (!freeSlots) {
+      // The slot is lost for reuse but the backing file stays intact
+      return;
+    }
+    chunkStore.freeSlots = freeSlots;
+    chunkStore.freeSlotsSize = freeSlotsSize;
+  }
+  chunkStore.freeSlots[chunkStore.freeSlotsCount++] = slot;
+}
+
+/**
+ * Evict the least recently used cols until the resident chunks and the chunk
+ * indexes fit into the budget. Cols used during the current move are kept.
+ */
+void chunkStoreEvict(void) {
+  while (
+    chunkStore.residentSize > chunkStore.budget &&
+    chunkStore.oldest &&
+    chunkStore.oldest->lastUse != chunkStore.clock
+  ) {
+    colPageOut(chunkStore.oldest->col);
+  }
+}
+
+/**
+ * Write the chunks of a resident col to the backing file and free them.
+ * @param col Resident chunked col instance
+ */
+void colPageOut(struct Col* col) {
+  struct ChunkIndex* chunkIndex = col->chunkIndex;
+  unsigned long chunkCount = col->size / COL_CHUNK_SIZE;
+  unsigned long slot;
+  struct Chunk* chunk;
+  
+  for (unsigned long i = 0; i < chunkCount; ++i) {
+    chunk = chunkIndex->chunks[i].chunk;
+    if (chunkStore.freeSlotsCount > 0) {
+      slot = chunkStore.freeSlots[--chunkStore.freeSlotsCount];
+    } else {
+      slot = chunkStore.slotsCount++;
+    }
+    if (pwrite(chunkStore.fd, chunk->pieces, sizeof(piece) * COL_CHUNK_SIZE,
+        slot * sizeof(piece) * COL_CHUNK_SIZE) != COL_CHUNK_SIZE) {
+      handleOutOfMemory("page out a column");
+    }
+    free(chunk);
+    chunkIndex->chunks[i].slot = slot;
+  }
+  
+  chunkIndex->resident = false;
+  chunkStoreUnlink(chunkIndex);
+  chunkStore.residentSize -= chunkCount * sizeof(struct Chunk);
+}
+
+/**
+ * Read the chunks of an evicted col back from the backing file.
+ * @param col Evicted chunked col instance
+ */
+void colPageIn(struct Col* col) {
+  struct ChunkIndex* chunkIndex = col->chunkIndex;
+  unsigned long chunkCount = col->size / COL_CHUNK_SIZE;
+  unsigned long slot;
+  struct Chunk* chunk;
+  
+  for (unsigned long i = 0; i < chunkCount; ++i) {
+    slot = chunkIndex->chunks[i].slot;
+    chunk = (struct Chunk*) malloc(sizeof(struct Chunk));
+    if (!chunk) {
+      handleOutOfMemory("page in a column");
+    }
+    if (pread(chunkStore.fd, chunk->pieces, sizeof(piece) * COL_CHUNK_SIZE,
+        slot * sizeof(piece) * COL_CHUNK_SIZE) != COL_CHUNK_SIZE) {
+      free(chunk);
+      handleOutOfMemory("page in a column");
+    }
+    chunk->removals = 0;
+    chunkIndex->chunks[i].chunk = chunk;
+    chunkStoreFreeSlot(slot);
+  }
+  
+  chunkIndex->resident = true;
+  chunkIndex->lastUse = chunkStore.clock;
+  chunkStoreLink(chunkIndex);
+  chunkStore.residentSize += chunkCount * sizeof(struct Chunk);
+}
+
+/**
+ * Check whether the given col node is a padding col.
+ * @param col Col instance
+ * @return True, if the col is a padding col
+ */
+inline bool colIsPadding(struct Col* col) {
+  return col->count & COL_PADDING_TAG;
+}
+
+/**
+ * Check whether the given col stores its pieces inline.
+ * @param col Col instance, must not be a padding col
+ * @return True, if the col stores its pieces inline
+ */
+inline bool colIsInline(struct Col* col) {
+  return col->size == COL_INLINE_SIZE;
+}
+
+/**
+ * Read the piece at the given Y-position inside a col.
+ * @param col Col instance
+ * @param y Piece Y-position, must be smaller than the col size
+ * @return Piece color
+ */
+inline piece colGetPiece(struct Col* col, unsigned long y) {
+  if (colIsInline(col)) {
+    return col->pieces[y];
+  }
+  if (!col->chunkIndex->resident) {
+    colPageIn(col);
+  }
+  return col->chunkIndex->chunks[y / COL_CHUNK_SIZE].chunk
+    ->pieces[y % COL_CHUNK_SIZE];
+}
+
+/**
+ * Write the piece at the given Y-position inside a col.
+ * @param col Col instance
+ * @param y Piece Y-position, must be smaller than the col size
+ * @param p Piece color
+ */
+inline void colSetPiece(struct Col* col, unsigned long y, piece p) {
+  if (colIsInline(col)) {
+    col->pieces[y] = p;
+  } else {
+    if (!col->chunkIndex->resident) {
+      colPageIn(col);
+    }
+    col->chunkIndex->chunks[y / COL_CHUNK_SIZE].chunk
+      ->pieces[y % COL_CHUNK_SIZE] = p;
+  }
+}
+
+/**
+ * Create a padding col node with the given size.
+ * @param size Number of padding cols
+ * @return Pointer to new col node
+ */
+struct Col* createPaddingCol(unsigned long size) {
+  struct Col* col = (struct Col*) malloc(sizeof(struct Col));
+  if (!col) {
+    handleOutOfMemory("create a padding column");
+  }
+  col->size = size;
+  col->count = COL_PADDING_TAG;
+  col->next = NULL;
+  col->prev = NULL;
+  return col;
+}
+
+/**
+ * Insert a piece at the given x-position.
+ * @param playground Playground instance
+ * @param x Position to insert the piece
+ * @param p Piece color to be inserted
+ */
+void playgroundPlacePiece(struct Playground* playground, long x, piece p) {
+  struct Col* col = playgroundGetCol(playground, x);
+
+  // Dynamically move to chunks or add a chunk if necessary
+  if (col->count == col->size) {
+    resizeCol(col, col->count + 1);
+  }
+
+  // Fast path: Lines are contiguous, so a piece not touching any piece of
+  // its color cannot complete a line. Skip line detection and change
+  // tracking. Changes need to be tracked in out-of-core mode to keep the
+  // col in memory.
+  if (!chunkStore.file && !colTouchesColor(col, col->count, p)) {
+    colSetPiece(col, col->count, p);
+    ++col->count;
+    if (playground->bitboard) {
+      bitboardPlacePiece(playground->bitboard, x, col);
+    }
+    playgroundTouchGuardCol(playground, col);
+    playground->cascadeDepth = 0;
+    playground->cascadeColsCount = 1;
+    if (playground->boardExport) {
+      playgroundExportMove(playground, col, x);
+    }
+    return;
+  }
+
+  // Append piece to the top of the col stack
+  colSetPiece(col, col->count, p);
+  playgroundTrackChange(playground, col, col->count);
+  ++col->count;
+  if (playground->bitboard) {
+    bitboardPlacePiece(playground->bitboard, x, col);
+  }
+
+  // Scan for lines, remove them, cause gravity and repeat the process until no
+  // more lines are being identified
+  playgroundRemoveVerticalLines(playground, col);
+  playgroundRemoveLines(playground);
+  playground->cascadeDepth = 0;
+  while (playground->pieceRemovalsCount > 0) {
+    playgroundCauseGravity(playground);
+    playgroundRemoveLines(playground);
+    ++playground->cascadeDepth;
+  }
+
+  playground->cascadeColsCount = playground->changedColsCount;
+  if (playground->boardExport) {
+    playgroundExportMove(playground, col, x);
+  }
+  playgroundClearChanges(playground);
+}
+
+/**
+ * Check whether a piece placed on top of a col would touch a piece of the
+ * same color in the col below or in the adjacent cols.
+ * @param col Col the piece is placed on
+ * @param y Y-position of the piece
+ * @param p Piece color
+ * @return True, if any adjacent piece is of the given color
+ */
+bool colTouchesColor(struct Col* col, unsigned long y, piece p) {
+  if (y > 0 && colGetPiece(col, y - 1) == p) {
+    return true;
+  }
+  struct Col* adjacentCols[2] = {col->prev, col->next};
+  for (int i = 0; i < 2; ++i) {
+    struct Col* adjacentCol = adjacentCols[i];
+    if (adjacentCol && !colIsPadding(adjacentCol)) {
+      for (unsigned long adjacentY = y > 0 ? y - 1 : 0;
+          adjacentY <= y + 1 && adjacentY < adjacentCol->count; ++adjacentY) {
+        if (colGetPiece(adjacentCol, adjacentY) == p) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * Insert a piece at the given x-position while recording the time it takes
+ * in the latency histogram. Reports the move if it is slower than the slow
+ * move threshold.
+ * @param playground Playground instance
+ * @param x Position to insert the piece
+ * @param p Piece color to be inserted
+ * @param lineNumber Input line number of the move
+ */
+void playgroundPlaceTimedPiece(struct Playground* playground, long x, piece p, unsigned long lineNumber) {
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  playgroundPlacePiece(playground, x, p);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  
+  unsigned long duration = (end.tv_sec - start.tv_sec) * 1000000000UL +
+    end.tv_nsec - start.tv_nsec;
+  ++latency.counts[latencyBucket(duration)];
+  ++latency.count;
+  latency.max = duration > latency.max ? duration : latency.max;
+  
+  if (duration > slowMoveThreshold) {
+    fprintf(stderr,
+      "Slow move: line %lu, x %ld, %lu ns, cascade depth %lu, %lu changed cols\n",
+      lineNumber, x, duration, playground->cascadeDepth,
+      playground->cascadeColsCount);
+  }
+}
+
+/**
+ * Find the latency histogram bucket of a value.
+ * @param latency Latency in nanoseconds
+ * @return Bucket index
+ */
+unsigned long latencyBucket(unsigned long latency) {
+  if (latency < LATENCY_SUB_BUCKETS) {
+    return latency;
+  }
+  int magnitude = 63 - __builtin_clzl(latency);
+  return (magnitude - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS +
+    ((latency >> (magnitude - LATENCY_SUB_BUCKET_BITS)) &
+      (LATENCY_SUB_BUCKETS - 1));
+}
+
+/**
+ * Determine the highest value falling into a latency histogram bucket.
+ * @param bucket Bucket index
+ * @return Latency in nanoseconds
+ */
+unsigned long latencyBucketValue(unsigned long bucket) {
+  if (bucket < LATENCY_SUB_BUCKETS) {
+    return bucket;
+  }
+  int shift = bucket / LATENCY_SUB_BUCKETS - 1;
+  unsigned long lowest =
+    (LATENCY_SUB_BUCKETS + bucket % LATENCY_SUB_BUCKETS) << shift;
+  return lowest + ((1UL << shift) - 1);
+}
+
+/**
+ * Determine the latency below or at which the given share of moves lie.
+ * @param histogram Latency histogram
+ * @param permille Share of moves in permille
+ * @return Latency in nanoseconds (upper bound of the bucket), at most the
+ * highest latency
+ */
+unsigned long latencyPercentile(struct LatencyHistogram* histogram, unsigned long permille) {
+  unsigned long rank = (histogram->count * permille + 999) / 1000;
+  unsigned long count = 0;
+  for (unsigned long i = 0; i < LATENCY_BUCKETS_COUNT; ++i) {
+    count += histogram->counts[i];
+    if (count >= rank && count > 0) {
+      unsigned long value = latencyBucketValue(i);
+      return value < histogram->max ? value : histogram->max;
+    }
+  }
+  return histogram->max;
+}
+
+/**
+ * Print move latency percentiles to stderr.
+ * @param histogram Latency histogram
+ */
+void latencyPrint(struct LatencyHistogram* histogram) {
+  fprintf(stderr,
+    "Move latency: %lu moves, p50 %lu ns, p99 %lu ns, p999 %lu ns, max %lu ns\n",
+    histogram->count,
+    latencyPercentile(histogram, 500),
+    latencyPercentile(histogram, 990),
+    latencyPercentile(histogram, 999),
+    histogram->max);
+}
+
+/**
+ * Reset the change state of changed cols and apply memory optimizations (col
+ * shrinking and removal).
+ * @param playground Playground instance
+ */
+void playgroundClearChanges(struct Playground* playground) {
+  struct Col* col;
+  for (unsigned long i = 0; i < playground->changedColsCount; ++i) {
+    col = playground->changedCols[i];
+    if (col->count == 0 && col != playground->originCol) {
+      // Found empty column not being at the origin, remove it
+      playgroundRemoveCol(playground, col);
+      continue;
+    } else if (!colIsInline(col) && col->count <= COL_INLINE_SIZE / 2) {
+      // Reset change state and move pieces back into the col node
+      col->changeY = col->size;
+      resizeCol(col, col->count);
+    } else if (col->count + 2 * COL_CHUNK_SIZE <= col->size) {
+      // Reset change state and free unused chunks, keeping one spare chunk to
+      // not free and allocate again while the col height oscillates
+      col->changeY = col->size;
+      resizeCol(col, col->count + COL_CHUNK_SIZE);
+    } else {
+      // Reset change state
+      col->changeY = col->size;
+    }
+    
+    // Keep recently changed cols in memory
+    if (chunkStore.file && !colIsInline(col)) {
+      chunkStoreTouch(col);
+    }
+  }
+  
+  // Clear changes
+  playground->changedColsCount = 0;
+  
+  // Move cold cols out of memory
+  if (chunkStore.file) {
+    chunkStoreEvict();
+    ++chunkStore.clock;
+  }
+}
+
+/**
+ * Finds the Col at the given x. Lazily creates a col instance if not done, yet.
+ * Lazily creates padding cols if necessary, but they are never returned.
+ * Inside this method make sure the linked list stays intact between creation
+ * calls to ensure the list can be freed up, again.
+ * @param playground Playground instance
+ * @param x Col position
+ * @return Pointer to Col struct
+ */
+struct Col* playgroundGetCol(struct Playground* playground, long x) {
+  struct Col* col;
+  
+  // Test basic search cases (cheap, in O(1))
+  if (x == 0) {
+    // Origin col requested
+    return playground->originCol;
+
+  } else if (x == playground->endColX) {
+    // End col requested
     return playground->endCol;
 
-  } else if (x > playground->endColX) {
-    // Requested col exceeds end col
+  } else if (x > playground->endColX) {
+    // Requested col exceeds end col
+
+    // Append new padding col, if necessary
+    if (playground->endColX + 1 < x) {
+      col = createPaddingCol(x - (long) playground->endColX - 1);
+      playground->endCol->next = col;
+      col->prev = playground->endCol;
+      playground->endCol = col;
+    }
+
+    // Append new col
+    col = createCol();
+    playground->endCol->next = col;
+    col->prev = playground->endCol;
+    playground->endCol = col;
+    playground->endColX = x;
+
+    return col;
+
+  } else if (x == playground->startColX) {
+    // Start col requested
+    return playground->startCol;
+
+  } else if (x < playground->startColX) {
+    // Requested col exceeds start col
+
+    // Prepend new padding col, if necessary
+    if (playground->startColX - 1 > x) {
+      col = createPaddingCol((long) playground->startColX - x - 1);
+      playground->startCol->prev = col;
+      col->next = playground->startCol;
+      playground->startCol = col;
+    }
+
+    // Prepend new col
+    col = createCol();
+    playground->startCol->prev = col;
+    col->next = playground->startCol;
+    playground->startCol = col;
+    playground->startColX = x;
+
+    return col;
+  }
+
+  // The easiest cases of finding a col were tested above
+  // Now we need to iterate to it (expensive)
+  col = playground->currentCol;
+  long i = playground->currentX;
+  struct Col* newCol;
+  
+  // Move iterator until reaching the desired position or the end
+  if (i <= x) {
+    // Move iterator forward
+    while (i < x) {
+      i += colIsPadding(col) ? col->size : 1;
+      col = col->next;
+    }
+  } else {
+    // Move iterator backward
+    while (i > x) {
+      col = col->prev;
+      i -= colIsPadding(col) ? col->size : 1;
+    }
+    if (i < x) {
+      // Ran past the x col, col must be of type padding (with size > 1).
+      // Move iterator behind that padding col resulting in the same situation
+      // as when moving the iterator forward.
+      i += col->size;
+      col = col->next;
+    }
+  }
+
+  if (i > x) {
+    // Ran past the x col, col->prev must be of type padding (with size > 1)
+    struct Col* lowerPadding = col->prev;
+
+    // Reduce lower padding to insert new col after it
+    lowerPadding->size -= i - x;
+
+    // Append new col after lower padding
+    newCol = createCol();
+    newCol->prev = lowerPadding;
+    lowerPadding->next = newCol;
+
+    // Append optional upper padding, if necessary
+    if (i - x > 1) {
+      newCol = createPaddingCol(i - x - 1);
+      newCol->prev = lowerPadding->next;
+      newCol->prev->next = newCol;
+    }
+
+    // Connect new col(s) to the current col
+    col->prev = newCol;
+    newCol->next = col;
+    col = lowerPadding->next;
+  }
+
+  if (colIsPadding(col)) {
+    // Create new col and connect it to the lower neighbour
+    newCol = createCol();
+    newCol->prev = col->prev;
+    col->prev->next = newCol;
+
+    if (col->size == 1) {
+      // Connect new col to the right neighbour, replacing the padding col
+      newCol->next = col->next;
+      newCol->next->prev = newCol;
+
+      // Let go padding col
+      freeCol(col);
+      col = newCol;
+    } else {
+      // Shrink down padding size by 1 and insert new col before it
+      col->size--;
+      newCol->next = col;
+      col->prev = newCol;
+      col = newCol;
+    }
+  }
+
+  // Update iterator
+  playground->currentCol = col;
+  playground->currentX = x;
+  return col;
+}
+
+/**
+ * Finds the col node covering the given x without modifying the playground,
+ * allowing concurrent lookups.
+ * @param playground Playground instance
+ * @param x Col position
+ * @param colX Pointer the position of the returned col node gets written to
+ * @return Pointer to the col node covering x, the start col if x lies below
+ * it or NULL if x lies above the end col
+ */
+struct Col* playgroundSeekCol(struct Playground* playground, long x, long* colX) {
+  if (x <= playground->startColX) {
+    *colX = playground->startColX;
+    return playground->startCol;
+  } else if (x > playground->endColX) {
+    return NULL;
+  }
+  
+  // Start at the closest known col
+  struct Col* col = playground->currentCol;
+  long i = playground->currentX;
+  if (x - playground->startColX < labs(x - i)) {
+    col = playground->startCol;
+    i = playground->startColX;
+  }
+  if (playground->endColX - x < labs(x - i)) {
+    col = playground->endCol;
+    i = playground->endColX;
+  }
+  
+  // Move iterator backward to a col starting at or below x
+  while (i > x) {
+    col = col->prev;
+    i -= colIsPadding(col) ? col->size : 1;
+  }
+  
+  // Move iterator forward to the col covering x
+  while (i + (long) (colIsPadding(col) ? col->size : 1) <= x) {
+    i += colIsPadding(col) ? col->size : 1;
+    col = col->next;
+  }
+  
+  *colX = i;
+  return col;
+}
+
+/**
+ * Remove the given col from the playground.
+ * Maintain the playground positions and pointers (startCol, currentCol, endCol)
+ * that must point to piece cols.
+ * @param playground Playground instance
+ * @param col Col to be removed. Must not be the origin col.
+ */
+void playgroundRemoveCol(struct Playground* playground, struct Col* col) {
+  struct Col* prevCol = col->prev;
+  struct Col* nextCol = col->next;
+  
+  // The col node may be freed or reused as padding col
+  if (playground->bitboard && playground->bitboard->valid) {
+    long i = bitboardColIndex(playground->bitboard, col);
+    if (i != -1) {
+      playground->bitboard->cols[i] = NULL;
+    }
+  }
+  
+  if (prevCol && nextCol) {
+    // The col has two adjacent cols
+    if (colIsPadding(prevCol) && colIsPadding(nextCol)) {
+      // Span the lower padding col over the upper padding col
+      prevCol->next = nextCol->next;
+      nextCol->next->prev = prevCol;
+      prevCol->size += nextCol->size + 1;
+      
+      if (playground->currentCol == col) {
+        playground->currentCol = prevCol->prev;
+        playground->currentX -= prevCol->size - nextCol->size;
+      }
+      
+      // Free dangling upper padding col
+      freeCol(nextCol);
+      
+    } else if (colIsPadding(prevCol) || colIsPadding(nextCol)) {
+      // Remove col and expand lower or upper padding
+      prevCol->next = nextCol;
+      nextCol->prev = prevCol;
+      if (colIsPadding(prevCol)) {
+        ++prevCol->size;
+        
+        if (playground->currentCol == col) {
+          playground->currentCol = nextCol;
+          ++playground->currentX;
+        }
+      } else {
+        ++nextCol->size;
+        
+        if (playground->currentCol == col) {
+          playground->currentCol = prevCol;
+          --playground->currentX;
+        }
+      }
+    } else {
+      // Col in between other cols, replace piece col by padding col
+      struct Col* paddingCol = createPaddingCol(1);
+      prevCol->next = paddingCol;
+      paddingCol->prev = prevCol;
+      nextCol->prev = paddingCol;
+      paddingCol->next = nextCol;
+      
+      if (playground->currentCol == col) {
+        playground->currentCol = prevCol;
+        --playground->currentX;
+      }
+    }
+
+    // Free dangling col
+    freeCol(col);
+  } else if (col == playground->startCol) {
+    // The col to be removed is at the lower end
+    // Remove col itself
+    struct Col* startCol = col->next;
+    freeCol(startCol->prev);
+    startCol->prev = NULL;
+    ++playground->startColX;
+    
+    // Remove dangling padding col
+    if (colIsPadding(startCol)) {
+      playground->startColX += startCol->size;
+      startCol = startCol->next;
+      freeCol(startCol->prev);
+      startCol->prev = NULL;
+    }
+    
+    // Update pointers
+    playground->startCol = startCol;
+    if (playground->currentCol == col) {
+      playground->currentCol = startCol;
+      playground->currentX = playground->startColX;
+    }
+  } else if (col == playground->endCol) {
+    // The col to be removed is at the upper end
+    // Remove col itself
+    struct Col* endCol = col->prev;
+    freeCol(endCol->next);
+    endCol->next = NULL;
+    playground->endColX--;
+    
+    // Remove dangling padding col
+    if (colIsPadding(endCol)) {
+      playground->endColX -= endCol->size;
+      endCol = endCol->prev;
+      freeCol(endCol->next);
+      endCol->next = NULL;
+    }
+    
+    // Update pointers
+    playground->endCol = endCol;
+    if (playground->currentCol == col) {
+      playground->currentCol = endCol;
+      playground->currentX = playground->endColX;
+    }
+  }
+}
+
+/**
+ * Identify horizontal (–) and diagonal (/, \) lines and mark pieces on those
+ * lines to be removed while tracking changes. Vertical lines are identified
+ * by playgroundRemoveVerticalLines while the col is being placed on or
+ * compacted.
+ * @param playground Playground
+ */
+void playgroundRemoveLines(struct Playground* playground) {
+  if (playground->bitboard && playgroundFocusBitboard(playground)) {
+    if (bitboardCheck) {
+      playgroundCheckBitboardLines(playground);
+    } else {
+      playgroundRemoveBitboardLines(playground);
+    }
+  } else if (rowSweep) {
+    playgroundRemoveSweepLines(playground);
+  } else {
+    playgroundWalkLines(playground);
+  }
+}
 
-    // Append new padding col, if necessary
-    if (playground->endColX + 1 < x) {
-      col = createPaddingCol(x - (long) playground->endColX - 1);
-      playground->endCol->next = col;
-      col->prev = playground->endCol;
-      playground->endCol = col;
+/**
+ * Identify horizontal and diagonal lines by walking the cols outward from
+ * each changed piece.
+ * @param playground Playground
+ */
+void playgroundWalkLines(struct Playground* playground) {
+  // Only consider cols where changes were applied
+  struct Col* col;
+  for (unsigned long i = 0; i < playground->changedColsCount; ++i) {
+    col = playground->changedCols[i];
+
+    // For each y above changeY identify crossing horizontal and diagonal lines
+    for (unsigned long y = col->changeY; y < col->count; ++y) {
+      // TODO: No need to search from pieces that are marked as removed
+      // Problem: The current data structure does not allow this in O(1)
+      playgroundRemoveLinesAt(playground, col, y);
     }
+  }
+}
 
-    // Append new col
-    col = createCol();
-    playground->endCol->next = col;
-    col->prev = playground->endCol;
-    playground->endCol = col;
-    playground->endColX = x;
+/**
+ * Identify horizontal (–) and diagonal (/, \) lines crossing a single piece
+ * and mark pieces on those lines to be removed.
+ * @param playground Playground
+ * @param col Col containing the piece
+ * @param y Y-position of the piece
+ */
+void playgroundRemoveLinesAt(struct Playground* playground, struct Col* col, unsigned long y) {
+  long nextY;
+  unsigned long lineLength;
+  int delY;
 
-    return col;
+  piece currentPiece = colGetPiece(col, y);
 
-  } else if (x == playground->startColX) {
-    // Start col requested
-    return playground->startCol;
+  struct Col* nextCol;
+  struct Col* lineEndCol;
+  struct Col* lineStartCol;
 
-  } else if (x < playground->startColX) {
-    // Requested col exceeds start col
+  // Iterate through directions falling diagonal (-1), horizontal (0) and
+  // climbing diagonal (1)
+  for (delY = -1; delY <= 1; ++delY) {
+    // Upper col the current line is ending
+    lineEndCol = col;
 
-    // Prepend new padding col, if necessary
-    if (playground->startColX - 1 > x) {
-      col = createPaddingCol((long) playground->startColX - x - 1);
-      playground->startCol->prev = col;
-      col->next = playground->startCol;
-      playground->startCol = col;
+    // Next col piece Y-index
+    nextCol = col->next;
+    nextY = y + delY;
+
+    // Line piece count
+    lineLength = 1;
+    
+    // Move forward while there is a next col, the next col is not a padding
+    // col, the next col is high enough and the next piece in it is of
+    // the current color or empty
+    while (
+      // Next column availability
+      nextCol &&
+      !colIsPadding(nextCol) &&
+      // Bounds of y-position
+      nextY >= 0 &&
+      nextY < nextCol->count &&
+      // Check piece color
+      colGetPiece(nextCol, nextY) == currentPiece
+    ) {
+      lineEndCol = nextCol;
+      nextCol = lineEndCol->next;
+      nextY += delY;
+      ++lineLength;
     }
 
-    // Prepend new col
-    col = createCol();
-    playground->startCol->prev = col;
-    col->next = playground->startCol;
-    playground->startCol = col;
-    playground->startColX = x;
+    // Do the same moving backward
+    lineStartCol = col;
+    nextCol = col->prev;
+    nextY = y - delY;
 
-    return col;
+    while (
+      // Next column availability
+      nextCol &&
+      !colIsPadding(nextCol) &&
+      // Bounds of y-position
+      nextY >= 0 &&
+      nextY < nextCol->count &&
+      // Check piece color
+      colGetPiece(nextCol, nextY) == currentPiece
+    ) {
+      lineStartCol = nextCol;
+      nextCol = lineStartCol->prev;
+      nextY -= delY;
+      ++lineLength;
+    }
+
+    if (lineLength >= MIN_LINE_COUNT) {
+      // We identified a horizontal or diagonal line (based on nextY)
+      // Iterate over line cols and remove each piece
+      nextY += delY;
+      nextCol = lineStartCol;
+      while (nextCol && nextCol->prev != lineEndCol) {
+        playgroundRemovePiece(playground, nextCol, nextY);
+        nextCol = nextCol->next;
+        nextY += delY;
+      }
+    }
   }
+}
 
-  // The easiest cases of finding a col were tested above
-  // Now we need to iterate to it (expensive)
-  col = playground->currentCol;
-  long i = playground->currentX;
-  struct Col* newCol;
+/**
+ * Identify horizontal and diagonal lines inside the bitboard window by
+ * comparing each window row to itself and to its neighbouring rows shifted by
+ * one col, testing all window cols of a row at once independent of their
+ * colors. As the board holds no lines before a round, each new line segment
+ * of MIN_LINE_COUNT pieces contains a changed piece, so only rows around
+ * changed rows need to be tested. Changed pieces near or outside the window
+ * bounds and lines that may continue outside of the window are left to
+ * playgroundRemoveLinesAt.
+ * @param playground Playground
+ */
+void playgroundRemoveBitboardLines(struct Playground* playground) {
+  struct Bitboard* bitboard = playground->bitboard;
+  unsigned long innerLo =
+    bitboard->y + (bitboard->y > 0 ? BITBOARD_GUARD_SIZE : 0);
+  unsigned long innerHi = bitboard->y + BITBOARD_HEIGHT - BITBOARD_GUARD_SIZE;
+  unsigned long y, from, to;
+  long lo = BITBOARD_HEIGHT;
+  long hi = 0;
+  long i, r, k;
+  struct Col* col;
+
+  // Collect the rows of changed pieces inside the inner window, fall back to
+  // the scalar detector for the other changed pieces
+  for (unsigned long j = 0; j < playground->changedColsCount; ++j) {
+    col = playground->changedCols[j];
+    from = col->count;
+    to = col->count;
+    i = bitboardColIndex(bitboard, col);
+    if (i >= BITBOARD_GUARD_SIZE && i < BITBOARD_WIDTH - BITBOARD_GUARD_SIZE) {
+      from = col->changeY > innerLo ? col->changeY : innerLo;
+      to = col->count < innerHi ? col->count : innerHi;
+      if (from < to) {
+        lo = (long) (from - bitboard->y) < lo ? (long) (from - bitboard->y) : lo;
+        hi = (long) (to - bitboard->y) > hi ? (long) (to - bitboard->y) : hi;
+      } else {
+        from = col->count;
+        to = col->count;
+      }
+    }
+    for (y = col->changeY; y < col->count; ++y) {
+      if (y == from) {
+        y = to - 1;
+      } else {
+        playgroundRemoveLinesAt(playground, col, y);
+      }
+    }
+  }
+
+  // Rows reachable by lines crossing changed rows
+  lo = lo - (MIN_LINE_COUNT - 1) > 0 ? lo - (MIN_LINE_COUNT - 1) : 0;
+  hi = hi + (MIN_LINE_COUNT - 1) < BITBOARD_HEIGHT ?
+    hi + (MIN_LINE_COUNT - 1) : BITBOARD_HEIGHT;
+  if (lo >= hi) {
+    return;
+  }
+
+  // Bit i of rows[r] is set if piece (i, r) of the window lies on a line.
+  // Bit i of climbing[r] (falling[r]) is set if piece (i, r) equals piece
+  // (i + 1, r + 1) (piece (i + 1, r - 1)).
+  uint64_t rows[BITBOARD_HEIGHT];
+  uint64_t climbing[BITBOARD_HEIGHT];
+  uint64_t falling[BITBOARD_HEIGHT];
+  uint64_t equal, starts;
+
+  for (r = lo; r < hi; ++r) {
+    // Horizontal (–): Bit i of starts is set if a line starts at (i, r)
+    equal = bitboardEqualMask(bitboard->cells[r], bitboard->cells[r] + 1);
+    starts = equal;
+    for (k = 1; k < MIN_LINE_COUNT - 1; ++k) {
+      starts &= equal >> k;
+    }
+    rows[r] = 0;
+    for (k = 0; k < MIN_LINE_COUNT; ++k) {
+      rows[r] |= starts << k;
+    }
+
+    climbing[r] = r + 1 < hi ?
+      bitboardEqualMask(bitboard->cells[r], bitboard->cells[r + 1] + 1) : 0;
+    falling[r] = r > lo ?
+      bitboardEqualMask(bitboard->cells[r], bitboard->cells[r - 1] + 1) : 0;
+  }
+
+  for (r = lo; r + MIN_LINE_COUNT - 1 < hi; ++r) {
+    // Climbing diagonal (/) starting at the bottom row r
+    starts = climbing[r];
+    for (k = 1; k < MIN_LINE_COUNT - 1; ++k) {
+      starts &= climbing[r + k] >> k;
+    }
+    for (k = 0; k < MIN_LINE_COUNT; ++k) {
+      rows[r + k] |= starts << k;
+    }
+
+    // Falling diagonal (\) starting at the top row r + MIN_LINE_COUNT - 1
+    starts = falling[r + MIN_LINE_COUNT - 1];
+    for (k = 1; k < MIN_LINE_COUNT - 1; ++k) {
+      starts &= falling[r + MIN_LINE_COUNT - 1 - k] >> k;
+    }
+    for (k = 0; k < MIN_LINE_COUNT; ++k) {
+      rows[r + MIN_LINE_COUNT - 1 - k] |= starts << k;
+    }
+  }
+
+  // Mark line pieces, complete lines touching the window bounds
+  for (r = lo; r < hi; ++r) {
+    for (uint64_t bits = rows[r]; bits; bits &= bits - 1) {
+      i = __builtin_ctzll(bits);
+      col = bitboard->cols[i];
+      playgroundRemovePiece(playground, col, bitboard->y + r);
+      if (i == 0 || i == BITBOARD_WIDTH - 1 || r == BITBOARD_HEIGHT - 1 ||
+          (r == 0 && bitboard->y > 0)) {
+        playgroundRemoveLinesAt(playground, col, bitboard->y + r);
+      }
+    }
+  }
+}
+
+/**
+ * Run the bitboard and the scalar detector independently on the same round
+ * and exit with an error if their marks differ in either direction (bitboard
+ * check mode). The round continues with the marks of the scalar detector.
+ * @param playground Playground
+ */
+void playgroundCheckBitboardLines(struct Playground* playground) {
+  unsigned long changedColsCount = playground->changedColsCount;
+  unsigned long pieceRemovalsCount = playground->pieceRemovalsCount;
+  unsigned long i, j;
+  struct Col* col;
   
-  // Move iterator until reaching the desired position or the end
-  if (i <= x) {
-    // Move iterator forward
-    while (i < x) {
-      i += col->type == COL_PADDING ? col->size : 1;
-      col = col->next;
+  // Remember the round state, including marks of vertical lines
+  uint32_t* changeYs = (uint32_t*) malloc(
+    (changedColsCount + 1) * sizeof(uint32_t));
+  if (!changeYs) {
+    handleOutOfMemory("check bitboard lines");
+  }
+  for (i = 0; i < changedColsCount; ++i) {
+    changeYs[i] = playground->changedCols[i]->changeY;
+  }
+  struct Mark* marks;
+  unsigned long marksCount = playgroundCollectMarks(playground, &marks);
+  
+  playgroundRemoveBitboardLines(playground);
+  struct Mark* bitboardMarks;
+  unsigned long bitboardMarksCount =
+    playgroundCollectMarks(playground, &bitboardMarks);
+  
+  // Restore the round state and run the scalar detector
+  for (i = 0; i < playground->changedColsCount; ++i) {
+    col = playground->changedCols[i];
+    colClearMarks(col);
+    col->changeY = i < changedColsCount ? changeYs[i] : col->size;
+  }
+  playground->changedColsCount = changedColsCount;
+  for (i = 0; i < marksCount; ++i) {
+    playgroundRemovePiece(playground, marks[i].col, marks[i].y);
+  }
+  playground->pieceRemovalsCount = pieceRemovalsCount;
+  
+  playgroundWalkLines(playground);
+  struct Mark* scalarMarks;
+  unsigned long scalarMarksCount =
+    playgroundCollectMarks(playground, &scalarMarks);
+  
+  // Compare both mark sets in order
+  qsort(bitboardMarks, bitboardMarksCount, sizeof(struct Mark), compareMarks);
+  qsort(scalarMarks, scalarMarksCount, sizeof(struct Mark), compareMarks);
+  unsigned long wrongCount = 0;
+  unsigned long missedCount = 0;
+  for (i = 0, j = 0; i < bitboardMarksCount || j < scalarMarksCount;) {
+    int order = i == bitboardMarksCount ? 1 : j == scalarMarksCount ? -1 :
+      compareMarks(&bitboardMarks[i], &scalarMarks[j]);
+    if (order < 0) {
+      ++wrongCount;
+      ++i;
+    } else if (order > 0) {
+      ++missedCount;
+      ++j;
+    } else {
+      ++i;
+      ++j;
     }
-  } else {
-    // Move iterator backward
-    while (i > x) {
-      col = col->prev;
-      i -= col->type == COL_PADDING ? col->size : 1;
+  }
+  
+  free(changeYs);
+  free(marks);
+  free(bitboardMarks);
+  free(scalarMarks);
+  if (wrongCount > 0 || missedCount > 0) {
+    fprintf(stderr,
+      "Bitboard line detection marked %lu pieces wrongly and missed %lu pieces\n",
+      wrongCount, missedCount);
+    exit(1);
+  }
+}
+
+/**
+ * Collect the pieces of changed cols marked to be removed.
+ * @param playground Playground
+ * @param marks Pointer the allocated array of marks gets written to
+ * @return Number of marks
+ */
+unsigned long playgroundCollectMarks(struct Playground* playground, struct Mark** marks) {
+  unsigned long count = 0;
+  unsigned long size = 1;
+  unsigned long i, y;
+  struct Col* col;
+  for (i = 0; i < playground->changedColsCount; ++i) {
+    col = playground->changedCols[i];
+    size += col->count > col->changeY ? col->count - col->changeY : 0;
+  }
+  *marks = (struct Mark*) malloc(size * sizeof(struct Mark));
+  if (!*marks) {
+    handleOutOfMemory("check bitboard lines");
+  }
+  for (i = 0; i < playground->changedColsCount; ++i) {
+    col = playground->changedCols[i];
+    for (y = col->changeY; y < col->count; ++y) {
+      if (colIsMarked(col, y)) {
+        (*marks)[count].col = col;
+        (*marks)[count].y = y;
+        ++count;
+      }
     }
-    if (i < x) {
-      // Ran past the x col, col must be of type padding (with size > 1).
-      // Move iterator behind that padding col resulting in the same situation
-      // as when moving the iterator forward.
-      i += col->size;
-      col = col->next;
+  }
+  return count;
+}
+
+/**
+ * Compare two marks by col address and y-position.
+ * @param a First mark
+ * @param b Second mark
+ * @return Negative, zero or positive if the first mark is ordered before,
+ * equal to or after the second mark
+ */
+int compareMarks(const void* a, const void* b) {
+  const struct Mark* markA = (const struct Mark*) a;
+  const struct Mark* markB = (const struct Mark*) b;
+  if (markA->col != markB->col) {
+    return (uintptr_t) markA->col < (uintptr_t) markB->col ? -1 : 1;
+  }
+  return (markA->y > markB->y) - (markA->y < markB->y);
+}
+
+/**
+ * Check whether a piece is marked to be removed.
+ * @param col Col instance
+ * @param y Y-position of the piece
+ * @return True, if the piece is marked
+ */
+bool colIsMarked(struct Col* col, unsigned long y) {
+  if (colIsInline(col)) {
+    return col->removals >> y & 1;
+  }
+  // Evicted cols hold no marks
+  return col->chunkIndex->resident &&
+    col->chunkIndex->chunks[y / COL_CHUNK_SIZE].chunk->removals >>
+      (y % COL_CHUNK_SIZE) & 1;
+}
+
+/**
+ * Clear the removal marks of a col.
+ * @param col Col instance
+ */
+void colClearMarks(struct Col* col) {
+  if (colIsInline(col)) {
+    col->removals = 0;
+  } else if (col->chunkIndex->resident) {
+    for (unsigned long k = 0; k * COL_CHUNK_SIZE < col->size; ++k) {
+      col->chunkIndex->chunks[k].chunk->removals = 0;
     }
   }
+}
 
-  if (i > x) {
-    // Ran past the x col, col->prev must be of type padding (with size > 1)
-    struct Col* lowerPadding = col->prev;
+/**
+ * Identify horizontal and diagonal lines by sweeping each row and diagonal
+ * crossing changed pieces once per run of adjacent changed pieces, in
+ * x-order, reading each of those pieces once. Sweeps start at the changed
+ * pieces not preceded by a changed piece in their direction. Line pieces get
+ * marked only once all sweeps are done, as marking changes cols and the
+ * sweeps rely on the changed pieces to tell where runs get swept from. Cols
+ * without changed neighbours share no rows or diagonals with other changed
+ * pieces and are left to playgroundRemoveLinesAt.
+ * @param playground Playground
+ */
+void playgroundRemoveSweepLines(struct Playground* playground) {
+  struct Col* col;
+  unsigned long i, y;
+  int delY;
+  
+  playground->sweepHeadsCount = 0;
+  for (i = 0; i < playground->changedColsCount; ++i) {
+    col = playground->changedCols[i];
+    if (col->changeY >= col->count) {
+      continue;
+    }
+    if (!colHasChangedNeighbour(col)) {
+      playgroundAppendSweepHead(playground, col, col->changeY, SWEEP_WALK);
+      continue;
+    }
+    // Changed pieces of the previous col, if any
+    long prevFrom = 0;
+    long prevTo = 0;
+    if (col->prev && !colIsPadding(col->prev)) {
+      prevFrom = col->prev->changeY;
+      prevTo = col->prev->count;
+    }
+    for (y = col->changeY; y < col->count; ++y) {
+      for (delY = -1; delY <= 1; ++delY) {
+        if ((long) y - delY < prevFrom || (long) y - delY >= prevTo) {
+          playgroundAppendSweepHead(playground, col, y, delY);
+        }
+      }
+    }
+  }
+  
+  // Sweep before marking any pieces, as marking changes cols
+  struct SweepHead* head;
+  playground->sweepMarksCount = 0;
+  for (i = 0; i < playground->sweepHeadsCount; ++i) {
+    head = &playground->sweepHeads[i];
+    if (head->delY != SWEEP_WALK) {
+      playgroundSweepLine(playground, head->col, head->y, head->delY);
+    }
+  }
+  for (i = 0; i < playground->sweepMarksCount; ++i) {
+    playgroundRemovePiece(playground, playground->sweepMarks[i].col,
+      playground->sweepMarks[i].y);
+  }
+  
+  for (i = 0; i < playground->sweepHeadsCount; ++i) {
+    head = &playground->sweepHeads[i];
+    if (head->delY == SWEEP_WALK) {
+      for (y = head->y; y < head->col->count; ++y) {
+        playgroundRemoveLinesAt(playground, head->col, y);
+      }
+    }
+  }
+}
 
-    // Reduce lower padding to insert new col after it
-    lowerPadding->size -= i - x;
+/**
+ * Sweep a row or diagonal from a changed piece through the following changed
+ * pieces and mark pieces on lines to be removed. Runs are extended in both
+ * directions beyond the changed pieces while they continue. Each run gets
+ * swept from its first changed piece only.
+ * @param playground Playground
+ * @param col Col of the first changed piece
+ * @param y Y-position of the first changed piece
+ * @param delY Direction: falling diagonal (-1), horizontal (0) or climbing
+ * diagonal (1)
+ */
+void playgroundSweepLine(struct Playground* playground, struct Col* col, unsigned long y, int delY) {
+  struct Col* startCol = col;
+  struct Col* changedCol;
+  long startY = y;
+  struct Col* nextCol;
+  long nextY;
+  unsigned long lineLength = 1;
+  piece p = colGetPiece(col, y);
+  piece next;
+  
+  // Extend the first run backward. If it reaches another changed piece of a
+  // swept col, the run and the changed pieces following it get swept from
+  // there.
+  while (
+    (nextCol = startCol->prev) != NULL &&
+    !colIsPadding(nextCol) &&
+    (nextY = startY - delY) >= 0 &&
+    nextY < (long) nextCol->count &&
+    colGetPiece(nextCol, nextY) == p
+  ) {
+    if (colIsChangedAt(nextCol, nextY) && colHasChangedNeighbour(nextCol)) {
+      return;
+    }
+    startCol = nextCol;
+    startY = nextY;
+    ++lineLength;
+  }
+  
+  while (true) {
+    // Extend the run forward, next holds the piece ending it
+    changedCol = col;
+    next = PIECE_EMPTY;
+    while (
+      (nextCol = col->next) != NULL &&
+      !colIsPadding(nextCol) &&
+      (nextY = (long) y + delY) >= 0 &&
+      nextY < (long) nextCol->count &&
+      (next = colGetPiece(nextCol, nextY)) == p
+    ) {
+      col = nextCol;
+      y = nextY;
+      ++lineLength;
+      next = PIECE_EMPTY;
+    }
+    
+    if (lineLength >= MIN_LINE_COUNT) {
+      // Mark the run
+      for (nextCol = startCol, nextY = startY; lineLength > 0;
+          nextCol = nextCol->next, nextY += delY, --lineLength) {
+        playgroundAppendSweepMark(playground, nextCol, nextY);
+      }
+    }
+    
+    // Continue with the next run if both the end of this run and the start
+    // of the next run are changed pieces. Otherwise the next run starts at a
+    // sweep head of its own.
+    if (next == PIECE_EMPTY ||
+        (col != changedCol && !colIsChangedAt(col, y)) ||
+        !colIsChangedAt(col->next, (long) y + delY)) {
+      return;
+    }
+    col = col->next;
+    y += delY;
+    startCol = col;
+    startY = y;
+    lineLength = 1;
+    p = next;
+  }
+}
 
-    // Append new col after lower padding
-    newCol = createCol();
-    newCol->prev = lowerPadding;
-    lowerPadding->next = newCol;
+/**
+ * Check whether the piece at the given Y-position of a col changed in the
+ * current round.
+ * @param col Col instance
+ * @param y Piece Y-position, may be out of range
+ * @return True, if the piece exists and changed
+ */
+inline bool colIsChangedAt(struct Col* col, long y) {
+  return !colIsPadding(col) && y >= (long) col->changeY &&
+    y < (long) col->count;
+}
 
-    // Append optional upper padding, if necessary
-    if (i - x > 1) {
-      newCol = createPaddingCol(i - x - 1);
-      newCol->prev = lowerPadding->next;
-      newCol->prev->next = newCol;
+/**
+ * Check whether a neighbouring col of a col changed in the current round.
+ * Changed cols without changed neighbours are not swept.
+ * @param col Col instance
+ * @return True, if the previous or next col has changed pieces
+ */
+bool colHasChangedNeighbour(struct Col* col) {
+  return (col->prev && !colIsPadding(col->prev) &&
+      col->prev->changeY < col->prev->count) ||
+    (col->next && !colIsPadding(col->next) &&
+      col->next->changeY < col->next->count);
+}
+
+/**
+ * Append a piece to be marked once all sweeps are done.
+ * @param playground Playground
+ * @param col Col of the piece
+ * @param y Y-position of the piece
+ */
+void playgroundAppendSweepMark(struct Playground* playground, struct Col* col, unsigned long y) {
+  if (playground->sweepMarksCount == playground->sweepMarksSize) {
+    playground->sweepMarksSize = playground->sweepMarksSize > 0 ?
+      2 * playground->sweepMarksSize : INITIAL_CHANGES_SIZE;
+    playground->sweepMarks = (struct Mark*) realloc(
+      playground->sweepMarks,
+      playground->sweepMarksSize * sizeof(struct Mark));
+    if (!playground->sweepMarks) {
+      handleOutOfMemory("sweep lines");
     }
+  }
+  struct Mark* mark = &playground->sweepMarks[playground->sweepMarksCount++];
+  mark->col = col;
+  mark->y = y;
+}
 
-    // Connect new col(s) to the current col
-    col->prev = newCol;
-    newCol->next = col;
-    col = lowerPadding->next;
+/**
+ * Append a piece to start sweeping rows and diagonals from.
+ * @param playground Playground
+ * @param col Col of the piece
+ * @param y Y-position of the piece
+ * @param delY Sweep direction or SWEEP_WALK
+ */
+void playgroundAppendSweepHead(struct Playground* playground, struct Col* col, unsigned long y, int delY) {
+  if (playground->sweepHeadsCount == playground->sweepHeadsSize) {
+    playground->sweepHeadsSize = playground->sweepHeadsSize > 0 ?
+      2 * playground->sweepHeadsSize : INITIAL_CHANGES_SIZE;
+    playground->sweepHeads = (struct SweepHead*) realloc(
+      playground->sweepHeads,
+      playground->sweepHeadsSize * sizeof(struct SweepHead));
+    if (!playground->sweepHeads) {
+      handleOutOfMemory("sweep lines");
+    }
   }
+  struct SweepHead* head = &playground->sweepHeads[playground->sweepHeadsCount++];
+  head->col = col;
+  head->y = y;
+  head->delY = delY;
+}
 
-  if (col->type == COL_PADDING) {
-    // Create new col and connect it to the lower neighbour
-    newCol = createCol();
-    newCol->prev = col->prev;
-    col->prev->next = newCol;
-
-    if (col->size == 1) {
-      // Connect new col to the right neighbour, replacing the padding col
-      newCol->next = col->next;
-      newCol->next->prev = newCol;
+/**
+ * Decide whether the changed pieces of a round are enough for the bitboard
+ * detector to pay off. If so, move the window over the changed rows around
+ * the last placed piece unless they are inside of it already.
+ * @param playground Playground instance
+ * @return True, if the round should be run on the bitboard window
+ */
+bool playgroundFocusBitboard(struct Playground* playground) {
+  struct Bitboard* bitboard = playground->bitboard;
+  unsigned long count = 0;
+  unsigned long minY = ULONG_MAX;
+  unsigned long maxY = 0;
+  struct Col* col;
 
-      // Let go padding col
-      free(col);
-      col = newCol;
-    } else {
-      // Shrink down padding size by 1 and insert new col before it
-      col->size--;
-      newCol->next = col;
-      col->prev = newCol;
-      col = newCol;
+  for (unsigned long j = 0; j < playground->changedColsCount; ++j) {
+    col = playground->changedCols[j];
+    if (col->changeY < col->count) {
+      count += col->count - col->changeY;
+      minY = col->changeY < minY ? col->changeY : minY;
+      maxY = col->count > maxY ? col->count : maxY;
     }
   }
 
-  // Update iterator
-  playground->currentCol = col;
-  playground->currentX = x;
-  return col;
+  // Check mode tests the bitboard detector on every round
+  if (count == 0 || (count < BITBOARD_MIN_CHANGES && !bitboardCheck)) {
+    return false;
+  }
+
+  long i = bitboard->focusX - bitboard->x;
+  if (
+    !bitboard->valid ||
+    !bitboardIsInner(bitboard, i, (long) minY - (long) bitboard->y) ||
+    !bitboardIsInner(bitboard, i, (long) maxY - 1 - (long) bitboard->y)
+  ) {
+    unsigned long centerY = (minY + maxY) / 2;
+    playgroundMoveBitboard(playground, bitboard->focusX - BITBOARD_WIDTH / 2,
+      centerY > BITBOARD_HEIGHT / 2 ? centerY - BITBOARD_HEIGHT / 2 : 0);
+  }
+  return true;
 }
 
 /**
- * Remove the given col from the playground.
- * Maintain the playground positions and pointers (startCol, currentCol, endCol)
- * that must point to piece cols.
+ * Move the bitboard window to the given lower left corner. Pieces covered by
+ * both the old and the new window are shifted, only newly covered pieces get
+ * copied from the cols.
  * @param playground Playground instance
- * @param col Col to be removed. Must not be the origin col.
+ * @param x Window x-position
+ * @param y Window y-position
  */
-void playgroundRemoveCol(struct Playground* playground, struct Col* col) {
-  struct Col* prevCol = col->prev;
-  struct Col* nextCol = col->next;
-  
-  if (prevCol && nextCol) {
-    // The col has two adjacent cols
-    if (prevCol->type == COL_PADDING && nextCol->type == COL_PADDING) {
-      // Span the lower padding col over the upper padding col
-      prevCol->next = nextCol->next;
-      nextCol->next->prev = prevCol;
-      prevCol->size += nextCol->size + 1;
-      
-      if (playground->currentCol == col) {
-        playground->currentCol = prevCol->prev;
-        playground->currentX -= prevCol->size - nextCol->size;
-      }
-      
-      // Free dangling upper padding col
-      free(nextCol);
-      
-    } else if (prevCol->type == COL_PADDING || nextCol->type == COL_PADDING) {
-      // Remove col and expand lower or upper padding
-      prevCol->next = nextCol;
-      nextCol->prev = prevCol;
-      if (prevCol->type == COL_PADDING) {
-        ++prevCol->size;
-        
-        if (playground->currentCol == col) {
-          playground->currentCol = nextCol;
-          ++playground->currentX;
-        }
-      } else {
-        ++nextCol->size;
-        
-        if (playground->currentCol == col) {
-          playground->currentCol = prevCol;
-          --playground->currentX;
-        }
+void playgroundMoveBitboard(struct Playground* playground, long x, unsigned long y) {
+  struct Bitboard* bitboard = playground->bitboard;
+  long dx = x - bitboard->x;
+  long dy = (long) y - (long) bitboard->y;
+  long i, r;
+  if (bitboard->valid && dx == 0 && dy == 0) {
+    return;
+  }
+
+  // New window cols [keepLo, keepHi) and rows [rowLo, rowHi) covered by the
+  // old window
+  long keepLo = 0;
+  long keepHi = 0;
+  long rowLo = 0;
+  long rowHi = 0;
+  if (bitboard->valid && labs(dx) < BITBOARD_WIDTH &&
+      labs(dy) < BITBOARD_HEIGHT) {
+    keepLo = dx < 0 ? -dx : 0;
+    keepHi = dx > 0 ? BITBOARD_WIDTH - dx : BITBOARD_WIDTH;
+    rowLo = dy < 0 ? -dy : 0;
+    rowHi = dy > 0 ? BITBOARD_HEIGHT - dy : BITBOARD_HEIGHT;
+  }
+
+  if (keepLo < keepHi) {
+    // Shift kept pieces, moving rows in an order not overwriting rows still
+    // to be moved
+    memmove(&bitboard->cols[keepLo], &bitboard->cols[keepLo + dx],
+      (keepHi - keepLo) * sizeof(struct Col*));
+    for (long n = 0; n < rowHi - rowLo; ++n) {
+      r = dy > 0 ? rowLo + n : rowHi - 1 - n;
+      memmove(bitboard->cells[r] + keepLo, bitboard->cells[r + dy] + keepLo + dx,
+        (keepHi - keepLo) * sizeof(piece));
+      memset(bitboard->cells[r], PIECE_EMPTY, keepLo * sizeof(piece));
+      memset(bitboard->cells[r] + keepHi, PIECE_EMPTY,
+        (BITBOARD_WIDTH - keepHi) * sizeof(piece));
+    }
+    for (r = 0; r < BITBOARD_HEIGHT; ++r) {
+      if (r < rowLo || r >= rowHi) {
+        memset(bitboard->cells[r], PIECE_EMPTY, sizeof(bitboard->cells[r]));
       }
-    } else {
-      // Col in between other cols, replace piece col by padding col
-      struct Col* paddingCol = createPaddingCol(1);
-      prevCol->next = paddingCol;
-      paddingCol->prev = prevCol;
-      nextCol->prev = paddingCol;
-      paddingCol->next = nextCol;
-      
-      if (playground->currentCol == col) {
-        playground->currentCol = prevCol;
-        --playground->currentX;
+    }
+    for (i = 0; i < BITBOARD_WIDTH; ++i) {
+      if (i < keepLo || i >= keepHi) {
+        bitboard->cols[i] = NULL;
       }
     }
+  } else {
+    memset(bitboard->cols, 0, sizeof(bitboard->cols));
+    memset(bitboard->cells, PIECE_EMPTY, sizeof(bitboard->cells));
+  }
 
-    // Free dangling col
-    free(col);
-  } else if (col == playground->startCol) {
-    // The col to be removed is at the lower end
-    // Remove col itself
-    struct Col* startCol = col->next;
-    free(startCol->prev);
-    startCol->prev = NULL;
-    ++playground->startColX;
-    
-    // Remove dangling padding col
-    if (startCol->type == COL_PADDING) {
-      playground->startColX += startCol->size;
-      startCol = startCol->next;
-      free(startCol->prev);
-      startCol->prev = NULL;
-    }
-    
-    // Update pointers
-    playground->startCol = startCol;
-    if (playground->currentCol == col) {
-      playground->currentCol = startCol;
-      playground->currentX = playground->startColX;
+  bitboard->x = x;
+  bitboard->y = y;
+  bitboard->valid = true;
+  bitboardIndexCols(bitboard);
+
+  // Copy newly covered rows of kept cols
+  for (i = keepLo; i < keepHi; ++i) {
+    if (bitboard->cols[i]) {
+      bitboardCopyRows(bitboard, i, 0, rowLo);
+      bitboardCopyRows(bitboard, i, rowHi, BITBOARD_HEIGHT);
     }
-  } else if (col == playground->endCol) {
-    // The col to be removed is at the upper end
-    // Remove col itself
-    struct Col* endCol = col->prev;
-    free(endCol->next);
-    endCol->next = NULL;
-    playground->endColX--;
-    
-    // Remove dangling padding col
-    if (endCol->type == COL_PADDING) {
-      playground->endColX -= endCol->size;
-      endCol = endCol->prev;
-      free(endCol->next);
-      endCol->next = NULL;
+  }
+
+  // Copy newly covered cols
+  playgroundFillBitboard(playground, 0, keepLo);
+  playgroundFillBitboard(playground, keepHi, BITBOARD_WIDTH);
+}
+
+/**
+ * Copy the cols between the given window indices to the window. Walks from
+ * the nearest window col outside of the range, seeks the cols if the window
+ * holds none.
+ * @param playground Playground instance
+ * @param from Lowest window index to be copied
+ * @param to Window index above the highest index to be copied
+ */
+void playgroundFillBitboard(struct Playground* playground, long from, long to) {
+  struct Bitboard* bitboard = playground->bitboard;
+  struct Col* col;
+  long colX, i;
+  if (from >= to) {
+    return;
+  }
+
+  // Walk backward from the lowest window col above the range
+  for (i = to; i < BITBOARD_WIDTH && !bitboard->cols[i]; ++i);
+  if (i < BITBOARD_WIDTH) {
+    colX = bitboard->x + i;
+    col = bitboard->cols[i]->prev;
+    for (; col && colX > bitboard->x + from; col = col->prev) {
+      if (colIsPadding(col)) {
+        colX -= col->size;
+      } else if (--colX < bitboard->x + to) {
+        bitboardSetCol(bitboard, colX - bitboard->x, col);
+        bitboardCopyRows(bitboard, colX - bitboard->x, 0, BITBOARD_HEIGHT);
+      }
     }
-    
-    // Update pointers
-    playground->endCol = endCol;
-    if (playground->currentCol == col) {
-      playground->currentCol = endCol;
-      playground->currentX = playground->endColX;
+    return;
+  }
+
+  // Walk forward from the highest window col below the range
+  for (i = from - 1; i >= 0 && !bitboard->cols[i]; --i);
+  if (i >= 0) {
+    colX = bitboard->x + i + 1;
+    col = bitboard->cols[i]->next;
+  } else {
+    col = playgroundSeekCol(playground, bitboard->x + from, &colX);
+  }
+  for (; col && colX < bitboard->x + to; col = col->next) {
+    if (colIsPadding(col)) {
+      colX += col->size;
+    } else {
+      if (colX >= bitboard->x + from) {
+        bitboardSetCol(bitboard, colX - bitboard->x, col);
+        bitboardCopyRows(bitboard, colX - bitboard->x, 0, BITBOARD_HEIGHT);
+      }
+      ++colX;
     }
   }
 }
 
 /**
- * Identify horizontal (–), vertical (|), diagonal (/, \) lines and mark pieces
- * on those lines as empty while tracking changes.
- * @param playground Playground
+ * Keep the bitboard window in sync with a piece placed on top of a col and
+ * focus upcoming detection rounds on its position.
+ * @param bitboard Bitboard window
+ * @param x Col x-position
+ * @param col Col the piece was placed on
  */
-void playgroundRemoveLines(struct Playground* playground) {
-  unsigned long j;
-  long y;
-  long nextY;
-  unsigned long lineLength;
-  int delY;
+void bitboardPlacePiece(struct Bitboard* bitboard, long x, struct Col* col) {
+  long i = x - bitboard->x;
+  bitboard->focusX = x;
+  if (!bitboard->valid || i < 0 || i >= BITBOARD_WIDTH) {
+    return;
+  }
+  if (bitboard->cols[i] != col) {
+    bitboardSetCol(bitboard, i, col);
+  }
+  unsigned long y = col->count - 1;
+  if (y >= bitboard->y && y < bitboard->y + BITBOARD_HEIGHT) {
+    bitboard->cells[y - bitboard->y][i] = colGetPiece(col, y);
+  }
+}
 
-  piece currentPiece;
-  piece lineColor;
+/**
+ * Set a window col and add it to the lookup table.
+ * @param bitboard Bitboard window
+ * @param i Window col index
+ * @param col Col at the window col index
+ */
+void bitboardSetCol(struct Bitboard* bitboard, long i, struct Col* col) {
+  bitboard->cols[i] = col;
+  if (bitboard->slotsCount >= BITBOARD_SLOTS / 2) {
+    // Drop slots left behind by removed cols
+    bitboardIndexCols(bitboard);
+  } else {
+    bitboardIndexCol(bitboard, i);
+  }
+}
 
-  struct Col* col;
-  struct Col* nextCol;
-  struct Col* lineEndCol;
-  struct Col* lineStartCol;
+/**
+ * Copy the pieces of a window col between the given window rows from the
+ * col. Cells above the col are expected to be empty.
+ * @param bitboard Bitboard window
+ * @param i Window col index
+ * @param from Lowest window row to be copied
+ * @param to Window row above the highest row to be copied
+ */
+void bitboardCopyRows(struct Bitboard* bitboard, long i, long from, long to) {
+  struct Col* col = bitboard->cols[i];
+  for (long r = from; r < to && bitboard->y + r < col->count; ++r) {
+    bitboard->cells[r][i] = colGetPiece(col, bitboard->y + r);
+  }
+}
 
-  // Only consider cols where changes were applied
-  for (unsigned long i = 0; i < playground->changedColsCount; ++i) {
-    col = playground->changedCols[i];
+/**
+ * Rebuild the window col lookup table.
+ * @param bitboard Bitboard window
+ */
+void bitboardIndexCols(struct Bitboard* bitboard) {
+  memset(bitboard->slots, 0, sizeof(bitboard->slots));
+  bitboard->slotsCount = 0;
+  for (long i = 0; i < BITBOARD_WIDTH; ++i) {
+    if (bitboard->cols[i]) {
+      bitboardIndexCol(bitboard, i);
+    }
+  }
+}
 
-    // For each y above changeY identify crossing horizontal and diagonal lines
-    for (y = col->changeY; y < col->count; ++y) {
-      currentPiece = col->pieces[y];
-      
-      // TODO: No need to search from pieces that are marked as removed
-      // Problem: The current data structure does not allow this in O(1)
-      
-      // Iterate through directions falling diagonal (-1), horizontal (0) and
-      // climbing diagonal (1)
-      for (delY = -1; delY <= 1; ++delY) {
-        // Upper col the current line is ending
-        lineEndCol = col;
+/**
+ * Add a window col to the lookup table.
+ * @param bitboard Bitboard window
+ * @param i Window col index
+ */
+void bitboardIndexCol(struct Bitboard* bitboard, long i) {
+  unsigned long slot = ((uintptr_t) bitboard->cols[i] * 0x9E3779B97F4A7C15ULL)
+    >> 32 & (BITBOARD_SLOTS - 1);
+  while (bitboard->slots[slot]) {
+    slot = (slot + 1) & (BITBOARD_SLOTS - 1);
+  }
+  bitboard->slots[slot] = i + 1;
+  ++bitboard->slotsCount;
+}
 
-        // Next col piece Y-index
-        nextCol = col->next;
-        nextY = y + delY;
+/**
+ * Find the window index of a col. Cols do not know their x-position, so the
+ * index is looked up by col address.
+ * @param bitboard Bitboard window
+ * @param col Col to be found
+ * @return Window index, -1 if the col is outside of the window
+ */
+long bitboardColIndex(struct Bitboard* bitboard, struct Col* col) {
+  unsigned long slot = ((uintptr_t) col * 0x9E3779B97F4A7C15ULL)
+    >> 32 & (BITBOARD_SLOTS - 1);
+  while (bitboard->slots[slot]) {
+    if (bitboard->cols[bitboard->slots[slot] - 1] == col) {
+      return bitboard->slots[slot] - 1;
+    }
+    slot = (slot + 1) & (BITBOARD_SLOTS - 1);
+  }
+  return -1;
+}
 
-        // Line piece count
-        lineLength = 1;
-        
-        // Move forward while there is a next col, the next col is not a padding
-        // col, the next col is high enough and the next piece in it is of
-        // the current color or empty
-        while (
-          // Next column availability
-          nextCol &&
-          nextCol->type == COL_PIECES &&
-          // Bounds of y-position
-          nextY >= 0 &&
-          nextY < nextCol->count &&
-          // Check piece color
-          nextCol->pieces[nextY] == currentPiece
-        ) {
-          lineEndCol = nextCol;
-          nextCol = lineEndCol->next;
-          nextY += delY;
-          ++lineLength;
-        }
+/**
+ * Check whether all lines crossing the given window piece lie inside of
+ * the window or reach it far enough to be detected in it.
+ * @param bitboard Bitboard window
+ * @param i Window col index
+ * @param r Window row index
+ * @return True, if the piece is not near the window bounds
+ */
+bool bitboardIsInner(struct Bitboard* bitboard, long i, long r) {
+  return
+    i >= BITBOARD_GUARD_SIZE && i < BITBOARD_WIDTH - BITBOARD_GUARD_SIZE &&
+    r >= (bitboard->y > 0 ? BITBOARD_GUARD_SIZE : 0) &&
+    r < BITBOARD_HEIGHT - BITBOARD_GUARD_SIZE;
+}
 
-        // Do the same moving backward
-        lineStartCol = col;
-        nextCol = col->prev;
-        nextY = y - delY;
-
-        while (
-          // Next column availability
-          nextCol &&
-          nextCol->type == COL_PIECES &&
-          // Bounds of y-position
-          nextY >= 0 &&
-          nextY < nextCol->count &&
-          // Check piece color
-          nextCol->pieces[nextY] == currentPiece
-        ) {
-          lineStartCol = nextCol;
-          nextCol = lineStartCol->prev;
-          nextY -= delY;
-          ++lineLength;
-        }
+/**
+ * Copy the pieces of a col between the given y-positions to the window.
+ * @param bitboard Bitboard window
+ * @param col Col that changed
+ * @param fromY Lowest changed y-position
+ * @param toY Y-position above the highest changed piece
+ */
+void bitboardUpdateCol(struct Bitboard* bitboard, struct Col* col, unsigned long fromY, unsigned long toY) {
+  long i = bitboardColIndex(bitboard, col);
+  if (i == -1) {
+    return;
+  }
+  unsigned long y = fromY > bitboard->y ? fromY : bitboard->y;
+  for (; y < toY && y < bitboard->y + BITBOARD_HEIGHT; ++y) {
+    bitboard->cells[y - bitboard->y][i] =
+      y < col->count ? colGetPiece(col, y) : PIECE_EMPTY;
+  }
+}
 
-        if (lineLength >= MIN_LINE_COUNT) {
-          // We identified a horizontal or diagonal line (based on nextY)
-          // Iterate over line cols and remove each piece
-          nextY += delY;
-          nextCol = lineStartCol;
-          while (nextCol && nextCol->prev != lineEndCol) {
-            playgroundRemovePiece(playground, nextCol, nextY);
-            nextCol = nextCol->next;
-            nextY += delY;
-          }
-        }
-      }
-    }
+/**
+ * Compare window pieces to the pieces one col further in another or the
+ * same window row.
+ * @param a Window row
+ * @param b Window row, offset by one col
+ * @return Mask having bit i set if a[i] is a piece of the color of b[i]. The
+ * last bit compares to a piece outside of the window and is always unset.
+ */
+uint64_t bitboardEqualMask(piece* a, piece* b) {
+  uint64_t mask = 0;
+#ifdef __SSE2__
+  __m128i empty = _mm_set1_epi8((char) PIECE_EMPTY);
+  for (int i = 0; i < BITBOARD_WIDTH; i += 16) {
+    __m128i pieces = _mm_loadu_si128((__m128i*) (a + i));
+    __m128i equal = _mm_andnot_si128(_mm_cmpeq_epi8(pieces, empty),
+      _mm_cmpeq_epi8(pieces, _mm_loadu_si128((__m128i*) (b + i))));
+    mask |= (uint64_t) (uint16_t) _mm_movemask_epi8(equal) << i;
+  }
+#else
+  for (int i = 0; i < BITBOARD_WIDTH; ++i) {
+    mask |= (uint64_t) (a[i] == b[i] && a[i] != PIECE_EMPTY) << i;
+  }
+#endif
+  return mask & ~((uint64_t) 1 << (BITBOARD_WIDTH - 1));
+}
 
-    // Remove all vertical lines above change mark in linear time
-    lineColor = PIECE_EMPTY;
-    lineLength = 0;
+/**
+ * Identify vertical (|) lines crossing the change mark of a col and mark
+ * pieces on those lines to be removed in linear time.
+ * @param playground Playground
+ * @param col Col to be scanned
+ */
+void playgroundRemoveVerticalLines(struct Playground* playground, struct Col* col) {
+  piece currentPiece;
+  piece lineColor = PIECE_EMPTY;
+  unsigned long lineLength = 0;
 
-    for (y = col->count - 1; y >= 0; y--) {
-      currentPiece = col->pieces[y];
-      if (currentPiece == lineColor) {
-        // Add piece to line
-        ++lineLength;
-        if (lineLength == MIN_LINE_COUNT) {
-          // Min line count fulfilled, remove pieces
-          for (j = 0; j < MIN_LINE_COUNT; ++j) {
-            playgroundRemovePiece(playground, col, y + j);
-          }
-        } else if (lineLength > MIN_LINE_COUNT) {
-          // Remove this next line piece
-          playgroundRemovePiece(playground, col, y);
+  for (long y = (long) col->count - 1; y >= 0; y--) {
+    currentPiece = colGetPiece(col, y);
+    if (currentPiece == lineColor) {
+      // Add piece to line
+      ++lineLength;
+      if (lineLength == MIN_LINE_COUNT) {
+        // Min line count fulfilled, remove pieces
+        for (unsigned long j = 0; j < MIN_LINE_COUNT; ++j) {
+          playgroundRemovePiece(playground, col, y + j);
         }
-      } else if (y >= col->changeY) {
-        // Reset line
-        lineColor = currentPiece;
-        lineLength = 1;
-      } else {
-        // Below the change mark we can stop searching for new lines
-        break;
+      } else if (lineLength > MIN_LINE_COUNT) {
+        // Remove this next line piece
+        playgroundRemovePiece(playground, col, y);
       }
+    } else if (y >= col->changeY) {
+      // Reset line
+      lineColor = currentPiece;
+      lineLength = 1;
+    } else {
+      // Below the change mark we can stop searching for new lines
+      break;
     }
   }
 }
 
 /**
  * Mark piece at the given Y-position inside a col as to be removed.
- * It will definetly be removed in the gravity step of the loop.
+ * It will definetly be removed in the gravity step of the loop. Pieces keep
+ * their color until then, so crossing lines can still be identified.
  * @param playground Playground instance
  * @param col Col instance to remove piece from
  * @param y Y-position of piece to be removed
  */
 void playgroundRemovePiece(struct Playground* playground, struct Col* col, unsigned long y) {
-  if (playground->pieceRemovalsCount == playground->pieceRemovalsSize) {
-    // Dynamically increase piece removal array size
-    playground->pieceRemovalsSize *= 2;
-    playground->pieceRemovals = (struct PieceRemoval*) realloc(
-      playground->pieceRemovals,
-      playground->pieceRemovalsSize * sizeof(struct PieceRemoval)
-    );
-  }
-  struct PieceRemoval *pieceRemoval =
-    &playground->pieceRemovals[playground->pieceRemovalsCount++];
-  pieceRemoval->col = col;
-  pieceRemoval->y = y;
+  if (colIsInline(col)) {
+    uint32_t bit = (uint32_t) 1 << y;
+    if (!(col->removals & bit)) {
+      col->removals |= bit;
+      ++playground->pieceRemovalsCount;
+    }
+  } else {
+    if (!col->chunkIndex->resident) {
+      colPageIn(col);
+    }
+    struct Chunk* chunk = col->chunkIndex->chunks[y / COL_CHUNK_SIZE].chunk;
+    uint64_t bit = (uint64_t) 1 << (y % COL_CHUNK_SIZE);
+    if (!(chunk->removals & bit)) {
+      chunk->removals |= bit;
+      ++playground->pieceRemovalsCount;
+    }
+  }
   playgroundTrackChange(playground, col, y);
 }
 
@@ -897,6 +4988,8 @@ void playgroundTrackChange(struct Playground* playground, struct Col* col, unsig
     
     // Append col to changed cols array
     playground->changedCols[playground->changedColsCount++] = col;
+
+    playgroundTouchGuardCol(playground, col);
   } else if (col->changeY > y) {
     // Update Y-position of the change
     col->changeY = y;
@@ -904,40 +4997,91 @@ void playgroundTrackChange(struct Playground* playground, struct Col* col, unsig
 }
 
 /**
- * Consumes the playground piece removals and lets pieces stacked above those
- * to be removed fall down. Updates the col count accordingly.
+ * Detect changes reaching shard guard cols.
+ * @param playground Playground instance
+ * @param col Col instance that changed
+ */
+void playgroundTouchGuardCol(struct Playground* playground, struct Col* col) {
+  for (unsigned long i = 0; i < playground->guardColsCount; ++i) {
+    if (playground->guardCols[i] == col) {
+      playground->guardTouched = true;
+    }
+  }
+}
+
+/**
+ * Consumes the piece removal marks and lets pieces stacked above those to be
+ * removed fall down. Updates the col count accordingly. While each col is
+ * still in cache its change mark is moved up to the lowest fallen piece and
+ * vertical lines crossing it are marked for the next round.
  * @param playground Playground instance
  */
 void playgroundCauseGravity(struct Playground* playground) {
-  unsigned long i;
+  unsigned long i, y, k;
   struct Col* col;
-  struct PieceRemoval* pieceRemoval;
-  
-  // Iterate through removals and mark pieces as empty in the playground
-  for (i = 0; i < playground->pieceRemovalsCount; ++i) {
-    pieceRemoval = &playground->pieceRemovals[i];
-    pieceRemoval->col->pieces[pieceRemoval->y] = PIECE_EMPTY;
-  }
+  struct Chunk* chunk;
   
-  // Clear piece removals array
+  // Clear piece removal count
   playground->pieceRemovalsCount = 0;
   
   // Iterate through cols where changes were applied
   for (i = 0; i < playground->changedColsCount; ++i) {
     col = playground->changedCols[i];
 
-    // Cause gravity on a single column
+    // Cause gravity on a single column chunk by chunk
     unsigned long removedPieces = 0;
-    for (unsigned long y = col->changeY; y < col->count; ++y) {
-      if (col->pieces[y] == PIECE_EMPTY) {
-        ++removedPieces;
-      } else {
-        col->pieces[y - removedPieces] = col->pieces[y];
+    unsigned long lowestRemovalY = col->count;
+    unsigned long fromY = col->changeY;
+    if (colIsInline(col)) {
+      for (y = col->changeY; y < col->count; ++y) {
+        if (col->removals & ((uint32_t) 1 << y)) {
+          if (removedPieces++ == 0) {
+            lowestRemovalY = y;
+          }
+        } else if (removedPieces > 0) {
+          col->pieces[y - removedPieces] = col->pieces[y];
+        }
+      }
+      col->removals = 0;
+    } else for (k = col->changeY / COL_CHUNK_SIZE; k * COL_CHUNK_SIZE < col->count; ++k) {
+      if (!col->chunkIndex->resident) {
+        colPageIn(col);
       }
+      chunk = col->chunkIndex->chunks[k].chunk;
+      if (removedPieces == 0 && chunk->removals == 0) {
+        // Nothing to remove or move in this chunk
+        continue;
+      }
+      
+      y = k * COL_CHUNK_SIZE;
+      for (unsigned long j = 0; j < COL_CHUNK_SIZE && y < col->count; ++j, ++y) {
+        if (chunk->removals & ((uint64_t) 1 << j)) {
+          if (removedPieces++ == 0) {
+            lowestRemovalY = y;
+          }
+        } else if (removedPieces > 0) {
+          colSetPiece(col, y - removedPieces, chunk->pieces[j]);
+        }
+      }
+      chunk->removals = 0;
     }
 
     // Update col piece count / height
     col->count -= removedPieces;
+    
+    // Only fallen pieces may form new lines. The change mark must not reach
+    // the col size as it would mark the col as unchanged.
+    if (lowestRemovalY < col->size) {
+      col->changeY = lowestRemovalY;
+    }
+    
+    if (removedPieces > 0) {
+      if (playground->bitboard && playground->bitboard->valid) {
+        bitboardUpdateCol(playground->bitboard, col, fromY,
+          col->count + removedPieces);
+      }
+      playgroundRemoveVerticalLines(playground, col);
+    }
   }
 }
 
@@ -951,10 +5095,24 @@ void playgroundPrint(struct Playground* playground) {
   
   if (!debug) {
     while (col) {
-      if (col->type == COL_PIECES) {
+      if (!colIsPadding(col) && !colIsInline(col) && !col->chunkIndex->resident) {
+        // Stream evicted column pieces from the backing file
+        piece pieces[COL_CHUNK_SIZE];
+        for (long unsigned j = 0; j < col->count; ++j) {
+          if (j % COL_CHUNK_SIZE == 0 && pread(chunkStore.fd, pieces,
+              sizeof(pieces), col->chunkIndex->chunks[j / COL_CHUNK_SIZE].slot *
+              sizeof(pieces)) != sizeof(pieces)) {
+            handleOutOfMemory("page in a column");
+          }
+          printf("%d %ld %lu\n", pieces[j % COL_CHUNK_SIZE], x, j);
+        }
+        // Iterate to the next col
+        ++x;
+        col = col->next;
+      } else if (!colIsPadding(col)) {
         // Print column pieces
         for (long unsigned j = 0; j < col->count; ++j) {
-          printf("%d %ld %lu\n", col->pieces[j], x, j);
+          printf("%d %ld %lu\n", colGetPiece(col, j), x, j);
         }
         // Iterate to the next col
         ++x;
@@ -969,18 +5127,19 @@ void playgroundPrint(struct Playground* playground) {
     printf("Playground: [%ld; %ld]", playground->startColX, playground->endColX);
     
     while (col) {
-      if (col->type == COL_PIECES) {
-        printf("\n[%8ld] col %2lu/%2lu |", x, col->count, col->size);
+      if (!colIsPadding(col)) {
+        printf("\n[%8ld] col %2lu/%2lu |", x, (unsigned long) col->count,
+          (unsigned long) col->size);
 
         // Print column pieces
         for (long unsigned j = 0; j < col->count; ++j) {
-          printf("%3hu|", col->pieces[j]);
+          printf("%3hu|", colGetPiece(col, j));
         }
         // Iterate to the next col
         ++x;
         col = col->next;
       } else {
-        printf("\n[%8ld] --- %lu cols ---", x, col->size);
+        printf("\n[%8ld] --- %lu cols ---", x, (unsigned long) col->size);
 
         // Iterate to the next col
         x = x + col->size;
@@ -0,0 +1,191 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Export test reader: Waits until the board published to a shared memory
+// object (see --export) holds a given number of moves, copies it following
+// the seqlock protocol, checks the segment layout and prints the board in
+// the output format of the program.
+//
+// Usage: reader <name> <moves>
+
+// ******************
+// *   CONSTANTS   *
+// ******************
+
+// Cache line size the sequence number is aligned to (as in src/main.c)
+#define CACHE_LINE_SIZE 64
+
+// Seconds to wait for the segment and the expected number of moves
+#define READER_TIMEOUT 60
+
+// ****************
+// *   STRUCTS    *
+// ****************
+
+// Header at the start of the export segment (as in src/main.c)
+struct ExportHeader {
+  _Alignas(CACHE_LINE_SIZE) atomic_ulong sequence;
+  unsigned long size;
+  unsigned long movesCount;
+  unsigned long colsCount;
+  unsigned long colsSize;
+  unsigned long piecesOffset;
+};
+
+// Col directory entry of the export segment (as in src/main.c)
+struct ExportCol {
+  long x;
+  unsigned long offset;
+  unsigned long count;
+  unsigned long size;
+};
+
+// *************
+// *   BODY   *
+// *************
+
+/**
+ * Check whether the reader ran out of time.
+ * @param start Start time
+ * @return True, if READER_TIMEOUT seconds have passed since start
+ */
+bool timedOut(struct timespec* start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec - start->tv_sec >= READER_TIMEOUT;
+}
+
+/**
+ * Check the layout of a board copy and print its pieces.
+ * @param board Consistent copy of the segment
+ * @return False, if the layout is broken
+ */
+bool printBoard(char* board) {
+  struct ExportHeader* header = (struct ExportHeader*) board;
+  struct ExportCol* cols = (struct ExportCol*) (board + sizeof(struct ExportHeader));
+  unsigned char* pieces = (unsigned char*) board + header->piecesOffset;
+  unsigned long piecesSize = header->size - header->piecesOffset;
+
+  if (header->colsCount > header->colsSize ||
+      header->piecesOffset < sizeof(struct ExportHeader) +
+        header->colsSize * sizeof(struct ExportCol) ||
+      header->piecesOffset > header->size) {
+    fprintf(stderr, "Broken export header\n");
+    return false;
+  }
+  for (unsigned long i = 0; i < header->colsCount; ++i) {
+    if ((i > 0 && cols[i].x <= cols[i - 1].x) || cols[i].count == 0 ||
+        cols[i].count > cols[i].size || cols[i].offset > piecesSize ||
+        cols[i].size > piecesSize - cols[i].offset) {
+      fprintf(stderr, "Broken export directory entry %lu\n", i);
+      return false;
+    }
+  }
+
+  for (unsigned long i = 0; i < header->colsCount; ++i) {
+    for (unsigned long j = 0; j < cols[i].count; ++j) {
+      printf("%d %ld %lu\n", pieces[cols[i].offset + j], cols[i].x, j);
+    }
+  }
+  return true;
+}
+
+/**
+ * Read the exported board once it holds the expected number of moves.
+ * @param argc Number of arguments
+ * @param argv Arguments (object name, number of moves)
+ * @return Exit code
+ */
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <name> <moves>\n", argv[0]);
+    return 1;
+  }
+  char* name = argv[1];
+  unsigned long movesCount = strtoul(argv[2], NULL, 10);
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  struct timespec pause = { 0, 1000000 };
+
+  // Wait for the segment to be created
+  int fd;
+  while ((fd = shm_open(name, O_RDONLY, 0)) == -1) {
+    if (timedOut(&start)) {
+      fprintf(stderr, "Shared memory segment %s not found\n", name);
+      return 1;
+    }
+    nanosleep(&pause, NULL);
+  }
+
+  char* segment = NULL;
+  unsigned long segmentSize = 0;
+  char* board = NULL;
+  struct stat status;
+  bool valid = false;
+
+  while (!timedOut(&start)) {
+    // Map the segment again if it has grown
+    if (fstat(fd, &status) == 0 && (unsigned long) status.st_size > segmentSize) {
+      if (segment) {
+        munmap(segment, segmentSize);
+      }
+      segmentSize = status.st_size;
+      segment = (char*) mmap(NULL, segmentSize, PROT_READ, MAP_SHARED, fd, 0);
+      board = (char*) realloc(board, segmentSize);
+      if (segment == MAP_FAILED || !board) {
+        fprintf(stderr, "Unable to map shared memory segment %s\n", name);
+        return 1;
+      }
+    }
+    if (segmentSize < sizeof(struct ExportHeader)) {
+      nanosleep(&pause, NULL);
+      continue;
+    }
+
+    // Copy the board, retry if it was being updated meanwhile
+    struct ExportHeader* header = (struct ExportHeader*) segment;
+    unsigned long sequence =
+      atomic_load_explicit(&header->sequence, memory_order_acquire);
+    unsigned long size = header->size;
+    if (sequence % 2 == 1 || size > segmentSize) {
+      continue;
+    }
+    memcpy(board, segment, size);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&header->sequence, memory_order_relaxed) != sequence) {
+      continue;
+    }
+
+    unsigned long boardMovesCount = ((struct ExportHeader*) board)->movesCount;
+    if (boardMovesCount > movesCount) {
+      fprintf(stderr, "Export holds %lu moves, expected %lu\n",
+        boardMovesCount, movesCount);
+      break;
+    }
+    if (boardMovesCount == movesCount) {
+      valid = printBoard(board);
+      break;
+    }
+    nanosleep(&pause, NULL);
+  }
+  if (!valid && timedOut(&start)) {
+    fprintf(stderr, "Timed out waiting for %lu moves\n", movesCount);
+  }
+
+  if (segment) {
+    munmap(segment, segmentSize);
+  }
+  free(board);
+  close(fd);
+  return valid ? 0 : 1;
+}